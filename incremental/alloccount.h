@@ -0,0 +1,117 @@
+#pragma once
+// Heap allocation counting for debug and benchmark builds.
+//
+// With INCREMENTAL_COUNT_ALLOCATIONS defined (Debug builds and every
+// benchmark), one translation unit per executable expands
+// INCREMENTAL_DEFINE_ALLOCATION_HOOK() at namespace scope to replace the
+// global operator new/delete, aligned forms included; every heap
+// allocation is then counted, in total and per thread. Without it the hook
+// expands to nothing and the counts stay at zero, so code can check them
+// unconditionally.
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#ifdef INCREMENTAL_COUNT_ALLOCATIONS
+constexpr bool kAllocationCountingEnabled = true;
+#else
+constexpr bool kAllocationCountingEnabled = false;
+#endif
+
+inline std::atomic<uint64_t> g_allocationCount{ 0 };
+inline thread_local uint64_t t_allocationCount = 0;
+
+// All threads
+inline uint64_t AllocationCount() {
+    return g_allocationCount.load(std::memory_order_relaxed);
+}
+
+// The calling thread only
+inline uint64_t ThreadAllocationCount() {
+    return t_allocationCount;
+}
+
+// Allocations made by any thread since construction
+class AllocationScope {
+public:
+    AllocationScope() : start(AllocationCount()) {}
+    uint64_t Count() const { return AllocationCount() - start; }
+
+private:
+    uint64_t start;
+};
+
+// Allocations made by the calling thread since construction, unaffected by
+// whatever other threads are doing
+class ThreadAllocationScope {
+public:
+    ThreadAllocationScope() : start(ThreadAllocationCount()) {}
+    uint64_t Count() const { return ThreadAllocationCount() - start; }
+
+private:
+    uint64_t start;
+};
+
+#ifdef INCREMENTAL_COUNT_ALLOCATIONS
+#ifdef _MSC_VER
+#define INCREMENTAL_NOINLINE __declspec(noinline)
+#else
+#define INCREMENTAL_NOINLINE __attribute__((noinline))
+#endif
+
+// What the replaced operators call. Not inlined, so the compiler does not
+// pair a free() it can see with an operator new and warn of a mismatch
+// (-Wmismatched-new-delete).
+INCREMENTAL_NOINLINE inline void* CountedAllocate(std::size_t size) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    t_allocationCount++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+INCREMENTAL_NOINLINE inline void CountedFree(void* p) noexcept {
+    std::free(p);
+}
+
+// Over-aligned types (alignas above the default new alignment)
+INCREMENTAL_NOINLINE inline void* CountedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    t_allocationCount++;
+    std::size_t align = (std::size_t)alignment;
+    std::size_t rounded = ((size ? size : 1) + align - 1) & ~(align - 1);
+#ifdef _WIN32
+    if (void* p = _aligned_malloc(rounded, align)) return p;
+#else
+    if (void* p = std::aligned_alloc(align, rounded)) return p;
+#endif
+    throw std::bad_alloc();
+}
+
+INCREMENTAL_NOINLINE inline void CountedFreeAligned(void* p) noexcept {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+#define INCREMENTAL_DEFINE_ALLOCATION_HOOK()                                                            \
+    void* operator new(std::size_t size) { return CountedAllocate(size); }                              \
+    void* operator new[](std::size_t size) { return CountedAllocate(size); }                            \
+    void operator delete(void* p) noexcept { CountedFree(p); }                                          \
+    void operator delete[](void* p) noexcept { CountedFree(p); }                                        \
+    void operator delete(void* p, std::size_t) noexcept { CountedFree(p); }                             \
+    void operator delete[](void* p, std::size_t) noexcept { CountedFree(p); }                           \
+    void* operator new(std::size_t size, std::align_val_t a) { return CountedAllocateAligned(size, a); }   \
+    void* operator new[](std::size_t size, std::align_val_t a) { return CountedAllocateAligned(size, a); } \
+    void operator delete(void* p, std::align_val_t) noexcept { CountedFreeAligned(p); }                 \
+    void operator delete[](void* p, std::align_val_t) noexcept { CountedFreeAligned(p); }               \
+    void operator delete(void* p, std::size_t, std::align_val_t) noexcept { CountedFreeAligned(p); }    \
+    void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { CountedFreeAligned(p); }
+#else
+#define INCREMENTAL_DEFINE_ALLOCATION_HOOK()
+#endif
@@ -0,0 +1,510 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <string>
+#include <vector>
+#include "definitions.h"
+
+// Player-configured auto-buy rules.
+//
+// A rule is written as text and compiled against the game's content:
+//
+//   buy Farm                                  whenever affordable
+//   buy Mine when Gold cost < 10% of stock    only while that cost is cheap
+//   keep House >= 10                          up to a count
+//   keep Farm >= 2 x Lumber Mill              relative to another building
+//
+// Every form compiles to one AutomationRule: buy `target` when
+//
+//   count[target] < ratio * count[reference] + offset      (count gate)
+//   amount[resource] >= stockFactor * nextCost[resource]    (stock gate)
+//   the next one is affordable
+//
+// AutomationEngine evaluates rules the way AffordabilityScheduler predicts
+// affordability. The count gate only changes when a building count does,
+// and both other conditions hold once the resource the rule waits longest
+// on reaches a known amount. Each open rule is queued on that resource,
+// keyed by the amount, in one min-heap per resource: production, rate
+// changes and spending move the stockpile, not the key, so they never
+// re-evaluate a rule, and the earliest trigger of a resource is its smallest
+// key. A rule is re-evaluated only when a count it reads changes, or when
+// its amount is reached and a condition it was not waiting on no longer
+// holds (a purchase spent another resource it needs). A tick with no events
+// costs a comparison per building and a look at the top of each heap,
+// however many rules there are.
+//
+// Because triggers follow in closed form from the stockpiles, Advance()
+// fast-forwards straight to each one and fires every rule at the moment it
+// would have, like GameState::Advance. Evaluations are O(purchases x rules
+// each purchase affects: those reading the bought building or needing a
+// resource it spent), not O(ticks).
+struct AutomationRule {
+    static constexpr double kUnlimited = std::numeric_limits<double>::infinity();
+
+    int32_t target = -1;            // Building to buy
+    int32_t reference = -1;         // Building the count gate scales with; -1 for none
+    int32_t resource = -1;          // Resource of the stock gate; -1 for none
+    int32_t reserved = 0;
+    double ratio = 0.0;
+    double offset = kUnlimited;     // No count gate by default
+    double stockFactor = 1.0;
+};
+static_assert(sizeof(AutomationRule) == 40, "AutomationRule is kept compact; 10k rules fit in 400 KB");
+
+namespace automation_detail {
+
+// Longest name in `names` at text[pos], followed by a space or the end
+inline int MatchName(const std::string& text, size_t& pos, const std::vector<std::string>& names) {
+    int best = -1;
+    size_t bestLength = 0;
+    for (int i = 0; i < (int)names.size(); i++) {
+        const std::string& name = names[i];
+        if (name.size() <= bestLength || text.compare(pos, name.size(), name) != 0) continue;
+        size_t end = pos + name.size();
+        if (end < text.size() && text[end] != ' ') continue;
+        best = i;
+        bestLength = name.size();
+    }
+    if (best >= 0) pos += bestLength;
+    return best;
+}
+
+inline bool MatchWord(const std::string& text, size_t& pos, const char* word) {
+    while (pos < text.size() && text[pos] == ' ') pos++;
+    size_t length = strlen(word);
+    if (text.compare(pos, length, word) != 0) return false;
+    pos += length;
+    while (pos < text.size() && text[pos] == ' ') pos++;
+    return true;
+}
+
+inline bool MatchNumber(const std::string& text, size_t& pos, double& value) {
+    const char* start = text.c_str() + pos;
+    char* end = nullptr;
+    value = strtod(start, &end);
+    if (end == start) return false;
+    pos += end - start;
+    while (pos < text.size() && text[pos] == ' ') pos++;
+    return true;
+}
+
+} // namespace automation_detail
+
+// Compile one rule (see the forms above). Names are the content's, in UTF-8.
+inline bool CompileAutomationRule(const std::string& text, const GameState& game, AutomationRule& rule,
+    std::string* error = nullptr) {
+    using namespace automation_detail;
+    auto fail = [&](const std::string& message) {
+        if (error) *error = "\"" + text + "\": " + message;
+        return false;
+    };
+
+    std::vector<std::string> buildings, resources;
+    for (const auto& type : game.buildingTypes) buildings.push_back(NarrowUtf8(type.name));
+    for (int r = 0; r < kResourceCount; r++) resources.push_back(NarrowUtf8(game.resourceNames[r]));
+
+    AutomationRule result;
+    size_t pos = 0;
+    if (MatchWord(text, pos, "buy ")) {
+        result.target = MatchName(text, pos, buildings);
+        if (result.target < 0) return fail("unknown building");
+
+        if (MatchWord(text, pos, "when ")) {
+            result.resource = MatchName(text, pos, resources);
+            if (result.resource < 0) return fail("unknown resource");
+            double percent;
+            if (!MatchWord(text, pos, "cost") || !MatchWord(text, pos, "<") || !MatchNumber(text, pos, percent) ||
+                !MatchWord(text, pos, "% of stock")) {
+                return fail("expected \"when <Resource> cost < <P>% of stock\"");
+            }
+            if (percent <= 0.0) return fail("the percentage must be positive");
+            result.stockFactor = 100.0 / percent;
+        }
+    }
+    else if (MatchWord(text, pos, "keep ")) {
+        result.target = MatchName(text, pos, buildings);
+        if (result.target < 0) return fail("unknown building");
+
+        double number;
+        if (!MatchWord(text, pos, ">=") || !MatchNumber(text, pos, number)) return fail("expected \">= <N>\"");
+        if (MatchWord(text, pos, "x ")) {
+            result.reference = MatchName(text, pos, buildings);
+            if (result.reference < 0) return fail("unknown building");
+            result.ratio = number;
+            result.offset = 0.0;
+        }
+        else {
+            result.offset = number;
+        }
+    }
+    else {
+        return fail("expected \"buy\" or \"keep\"");
+    }
+
+    while (pos < text.size() && text[pos] == ' ') pos++;
+    if (pos != text.size()) return fail("unexpected text at the end");
+    rule = result;
+    return true;
+}
+
+// One rule per line; blank lines and lines starting with '#' are skipped
+inline bool LoadAutomationRules(const std::string& path, const GameState& game, std::vector<AutomationRule>& rules,
+    std::string* error = nullptr) {
+    std::string text;
+    if (!ReadTextFile(path, text)) {
+        if (error) *error = "cannot read file";
+        return false;
+    }
+
+    rules.clear();
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(start, end - start);
+        start = end + 1;
+
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t first = line.find_first_not_of(' ');
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        AutomationRule rule;
+        if (!CompileAutomationRule(line.substr(first), game, rule, error)) return false;
+        rules.push_back(rule);
+    }
+    return true;
+}
+
+class AutomationEngine {
+public:
+    static constexpr double kNever = std::numeric_limits<double>::infinity();
+
+    // A trigger this close is treated as now; the shortfall it leaves is
+    // closed-form rounding, absorbed as GameState::Advance does
+    static constexpr double kDueTolerance = 1e-6;
+
+    // Safety limit for content that never gets more expensive
+    static constexpr int kMaxPurchasesPerUpdate = 1000;
+
+    void SetRules(std::vector<AutomationRule> newRules) {
+        rules = std::move(newRules);
+        built = false;
+    }
+
+    const std::vector<AutomationRule>& Rules() const { return rules; }
+
+    // Fire every rule due by `now` (seconds on the caller's clock, which
+    // only has to advance at the same rate as the game). `purchase(index)`
+    // buys a building and returns whether it succeeded, so a caller can
+    // route purchases through its command log. Returns the purchases made.
+    template <typename Purchase>
+    int Update(GameState& game, double now, Purchase&& purchase) {
+        if (!built || game.contentVersion != contentVersion || buildingVersions.size() != game.buildings.size()) {
+            Rebuild(game);
+        }
+
+        int purchases = 0;
+        while (true) {
+            CollectChanges(game);
+            for (int rule : dirty) Evaluate(game, rule, now);
+            dirty.clear();
+
+            // One purchase at a time: it changes the inputs of other rules
+            int rule = PopDue(game, now);
+            if (rule < 0) break;
+
+            // Its heap only tracked the binding resource; check the rest
+            if (Predict(game, rule) > kDueTolerance) {
+                Evaluate(game, rule, now);
+                continue;
+            }
+
+            int target = rules[rule].target;
+            AbsorbShortfall(game, target);
+            if (purchase(target)) {
+                purchases++;
+                purchasesMade++;
+                if (purchases >= kMaxPurchasesPerUpdate) break;
+            }
+            else {
+                // Refused by the caller; look at it again next time
+                MarkDirty(rule);
+                break;
+            }
+        }
+        return purchases;
+    }
+
+    int Update(GameState& game, double now) {
+        return Update(game, now, [&game](int index) { return game.PurchaseBuilding(index); });
+    }
+
+    // Fast-forward the game by `seconds` from `now` in closed form, waking
+    // only at trigger times. Cost is O(purchases), not O(seconds).
+    int Advance(GameState& game, double now, double seconds) {
+        int purchases = Update(game, now);
+        double end = now + seconds;
+        while (now < end) {
+            // A trigger left over from a capped Update is due now
+            double next = std::max(now, std::min(NextEventTime(game, now), end));
+            game.AdvanceLinear(next - now);
+            now = next;
+
+            int fired = Update(game, now);
+            purchases += fired;
+            if (fired == 0 && next >= end) break;
+        }
+        return purchases;
+    }
+
+    // Earliest pending trigger at the game's current rates, on the clock
+    // of `now`, for sleeping until something happens
+    double NextEventTime(const GameState& game, double now) {
+        double next = kNever;
+        if (TopLive(ready)) next = ready.top().time;
+        for (int r = 0; r < kResourceCount; r++) {
+            if (TopLive(waiting[r])) next = std::min(next, now + Wait(game, r, waiting[r].top().amount));
+        }
+        return next;
+    }
+
+    int64_t Evaluations() const { return evaluations; }
+    int64_t Purchases() const { return purchasesMade; }
+
+    size_t PendingEvents() const {
+        size_t pending = ready.size();
+        for (const auto& queue : waiting) pending += queue.size();
+        return pending;
+    }
+
+private:
+    static constexpr int kIdle = -1;                // Waiting on a count: not queued
+    static constexpr int kReady = kResourceCount;   // Nothing short: queued in `ready`
+
+    struct State {
+        uint64_t generation = 0;        // Invalidates older heap events
+        BigNumber threshold;            // Amount of the binding resource that fires the rule
+        double readyTime = kNever;      // When the rule became due, for kReady
+        int queue = kIdle;              // Resource whose heap holds the trigger, or kIdle / kReady
+        bool dirty = false;
+    };
+
+    // A rule with nothing short, due since `time`
+    struct Event {
+        double time;
+        int rule;
+        uint64_t generation;
+
+        // Earlier first; simultaneous triggers in rule order
+        bool operator>(const Event& other) const {
+            return time != other.time ? time > other.time : rule > other.rule;
+        }
+    };
+
+    // A rule waiting for its binding resource to reach `amount`
+    struct Threshold {
+        BigNumber amount;
+        int rule;
+        uint64_t generation;
+
+        bool operator>(const Threshold& other) const {
+            return amount != other.amount ? amount > other.amount : rule > other.rule;
+        }
+    };
+
+    template <typename T>
+    using MinHeap = std::priority_queue<T, std::vector<T>, std::greater<T>>;
+
+    std::vector<AutomationRule> rules;
+    std::vector<State> states;
+    MinHeap<Event> ready;
+    MinHeap<Threshold> waiting[kResourceCount];
+    std::vector<int> dirty;
+
+    // Rules to re-evaluate when a count moves; a count can open the gate or
+    // raise a cost
+    std::vector<std::vector<int>> rulesByBuilding;
+
+    // What the game looked like when the rules were last brought up to date
+    bool built = false;
+    uint64_t contentVersion = ~0ull;
+    std::vector<uint64_t> buildingVersions;
+
+    int64_t evaluations = 0;
+    int64_t purchasesMade = 0;
+
+    void Rebuild(const GameState& game) {
+        built = true;
+        contentVersion = game.contentVersion;
+        int buildingCount = (int)game.buildings.size();
+
+        states.assign(rules.size(), State());
+        ready = MinHeap<Event>();
+        for (auto& queue : waiting) queue = MinHeap<Threshold>();
+        dirty.clear();
+        rulesByBuilding.assign(buildingCount, {});
+
+        for (int i = 0; i < (int)rules.size(); i++) {
+            const AutomationRule& rule = rules[i];
+
+            // Rules compiled against other content stay idle
+            if (rule.target < 0 || rule.target >= buildingCount || rule.reference >= buildingCount) continue;
+
+            rulesByBuilding[rule.target].push_back(i);
+            if (rule.reference >= 0 && rule.reference != rule.target) rulesByBuilding[rule.reference].push_back(i);
+            MarkDirty(i);
+        }
+
+        buildingVersions.resize(buildingCount);
+        for (int b = 0; b < buildingCount; b++) buildingVersions[b] = game.buildings[b].version;
+    }
+
+    // Compare the building change counters; mark the rules that read what
+    // moved. Resources need no tracking: triggers are keyed by amount.
+    void CollectChanges(const GameState& game) {
+        for (int b = 0; b < (int)buildingVersions.size(); b++) {
+            if (game.buildings[b].version == buildingVersions[b]) continue;
+            buildingVersions[b] = game.buildings[b].version;
+            for (int rule : rulesByBuilding[b]) MarkDirty(rule);
+        }
+    }
+
+    void MarkDirty(int rule) {
+        if (states[rule].dirty) return;
+        states[rule].dirty = true;
+        dirty.push_back(rule);
+    }
+
+    // Seconds until the rule fires, kNever while the count gate is shut or a
+    // resource it is short of does not grow. The time is the latest of the
+    // per-resource waits, so it is reached when the resource setting it (the
+    // binding resource, -1 if nothing is short) gets to `threshold`.
+    double Predict(const GameState& game, int index, int* binding = nullptr, BigNumber* threshold = nullptr) const {
+        const AutomationRule& rule = rules[index];
+        if (binding) *binding = -1;
+        int referenceCount = rule.reference >= 0 ? game.buildings[rule.reference].count : 0;
+        if (!(game.buildings[rule.target].count < rule.ratio * referenceCount + rule.offset)) return kNever;
+
+        double wait = 0.0;
+        bool shortOfAny = false;
+        const ResourceAmounts& cost = game.buildings[rule.target].GetNextCost();
+        for (int r = 0; r < kResourceCount; r++) {
+            BigNumber needed = cost[r];
+            if (rule.resource == r && rule.stockFactor > 1.0) needed = needed * rule.stockFactor;
+            if (needed <= 0.0 || needed <= game.amounts[r]) continue;
+
+            double resourceWait = Wait(game, r, needed);
+            if (!shortOfAny || resourceWait > wait) {
+                wait = resourceWait;
+                shortOfAny = true;
+                if (binding) *binding = r;
+                if (threshold) *threshold = needed;
+            }
+        }
+        return wait;
+    }
+
+    // Seconds until resource r reaches `amount` at the current rate; zero or
+    // less if it has
+    static double Wait(const GameState& game, int r, const BigNumber& amount) {
+        BigNumber shortfall = amount - game.amounts[r];
+        double rate = game.rates[r];
+        if (rate > 0.0) return (shortfall / rate).ToDouble();
+        return shortfall <= 0.0 ? 0.0 : kNever;
+    }
+
+    // Re-predict the rule and queue its trigger
+    void Evaluate(const GameState& game, int index, double now) {
+        evaluations++;
+        State& state = states[index];
+        state.dirty = false;
+        state.generation++;
+        state.queue = kIdle;
+
+        int binding;
+        BigNumber threshold;
+        double wait = Predict(game, index, &binding, &threshold);
+        if (binding >= 0) {
+            state.queue = binding;
+            state.threshold = threshold;
+            waiting[binding].push(Threshold{ threshold, index, state.generation });
+        }
+        else if (wait != kNever) {
+            state.queue = kReady;
+            state.readyTime = now;
+            ready.push(Event{ now, index, state.generation });
+        }
+
+        // Stale events pile up as rules are re-evaluated; start over when
+        // they outnumber the live ones
+        if (PendingEvents() > 2 * rules.size() + 1024) RebuildQueues();
+    }
+
+    void RebuildQueues() {
+        std::vector<Event> readyLive;
+        std::vector<Threshold> waitingLive[kResourceCount];
+        for (int i = 0; i < (int)states.size(); i++) {
+            const State& state = states[i];
+            if (state.queue == kReady) readyLive.push_back(Event{ state.readyTime, i, state.generation });
+            else if (state.queue != kIdle) waitingLive[state.queue].push_back(Threshold{ state.threshold, i, state.generation });
+        }
+        ready = MinHeap<Event>(std::greater<Event>(), std::move(readyLive));
+        for (int r = 0; r < kResourceCount; r++) {
+            waiting[r] = MinHeap<Threshold>(std::greater<Threshold>(), std::move(waitingLive[r]));
+        }
+    }
+
+    // Drop stale events from the top; whether a live one is left
+    template <typename T>
+    bool TopLive(MinHeap<T>& queue) {
+        while (!queue.empty() && queue.top().generation != states[queue.top().rule].generation) queue.pop();
+        return !queue.empty();
+    }
+
+    // The due rule that triggered first, or -1. Ties go in rule order.
+    int PopDue(const GameState& game, double now) {
+        int best = -1;
+        int bestQueue = kIdle;
+        double bestWait = kDueTolerance;
+        if (TopLive(ready) && ready.top().time - now <= bestWait) {
+            best = ready.top().rule;
+            bestQueue = kReady;
+            bestWait = ready.top().time - now;
+        }
+        for (int r = 0; r < kResourceCount; r++) {
+            if (!TopLive(waiting[r])) continue;
+            const Threshold& top = waiting[r].top();
+            double wait = Wait(game, r, top.amount);
+            if (wait < bestWait || (wait == bestWait && (best < 0 || top.rule < best))) {
+                best = top.rule;
+                bestQueue = r;
+                bestWait = wait;
+            }
+        }
+        if (best < 0) return -1;
+
+        if (bestQueue == kReady) ready.pop();
+        else waiting[bestQueue].pop();
+        states[best].queue = kIdle;
+        return best;
+    }
+
+    // The trigger time is exact; close the rounding gap to the cost so the
+    // purchase cannot be missed
+    static void AbsorbShortfall(GameState& game, int target) {
+        if (game.CanAfford(target) || game.TimeUntilAffordable(target) > kDueTolerance) return;
+        const ResourceAmounts& cost = game.buildings[target].GetNextCost();
+        for (int r = 0; r < kResourceCount; r++) {
+            if (game.amounts[r] < cost[r]) {
+                game.amounts[r] = cost[r];
+                game.amountVersions[r]++;
+                game.adjustmentVersions[r]++;
+            }
+        }
+    }
+};
@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "game.h"
+#include "threadpool.h"
+
+// Many independent game states simulated together, e.g. player saves for
+// server-side balance analytics.
+//
+// Instances are stored column-wise: one contiguous array per resource for
+// mantissas, exponents and rates, and one per building type for counts.
+// A tick is a straight loop over those columns, split across a thread pool.
+//
+// Per-instance semantics match GameState exactly. Tick() replicates
+// GameState::Update, and purchases and gathers are applied by loading the
+// instance into a scratch GameState and running the real code.
+class BatchSimulation {
+public:
+    // Instances handled per thread-pool task
+    static constexpr int64_t kChunkSize = 4096;
+
+    explicit BatchSimulation(int instanceCount = 0) {
+        for (int r = 0; r < kResourceCount; r++) {
+            mantissas[r].resize(instanceCount);
+            exponents[r].resize(instanceCount);
+            rates[r].resize(instanceCount);
+        }
+        counts.resize(scratch.buildings.size());
+        for (auto& column : counts) column.resize(instanceCount);
+        gameTimes.resize(instanceCount);
+
+        // Every instance starts as a fresh game
+        for (int i = 0; i < instanceCount; i++) StoreInstance(i, scratch);
+    }
+
+    int InstanceCount() const { return (int)gameTimes.size(); }
+    int BuildingCount() const { return (int)counts.size(); }
+
+    // Advance every instance by one frame, identical to GameState::Update
+    void Tick(float deltaTime, ThreadPool& pool) {
+        pool.ParallelFor(0, InstanceCount(), kChunkSize, [&](int64_t begin, int64_t end) {
+            TickRange(deltaTime, begin, end);
+            });
+    }
+
+    // Single-threaded tick, for callers without a pool
+    void Tick(float deltaTime) {
+        TickRange(deltaTime, 0, InstanceCount());
+    }
+
+    // Same as GameState::PurchaseBuilding on one instance
+    bool PurchaseBuilding(int instance, int buildingIndex) {
+        LoadInstance(instance, scratch);
+        if (!scratch.PurchaseBuilding(buildingIndex)) return false;
+        StoreInstance(instance, scratch);
+        return true;
+    }
+
+    // Same as GameState::GatherResource on one instance
+    void GatherResource(int instance, ResourceType type, BigNumber amount) {
+        BigNumber value = GetAmount(instance, (int)type);
+        value += amount;
+        mantissas[(int)type][instance] = value.mantissa;
+        exponents[(int)type][instance] = value.exponent;
+    }
+
+    BigNumber GetAmount(int instance, int resource) const {
+        BigNumber value;
+        value.mantissa = mantissas[resource][instance];
+        value.exponent = exponents[resource][instance];
+        return value;
+    }
+
+    int GetCount(int instance, int buildingIndex) const {
+        return counts[buildingIndex][instance];
+    }
+
+    // Copy one instance into a GameState (which must use the default content)
+    void LoadInstance(int instance, GameState& game) const {
+        for (int r = 0; r < kResourceCount; r++) {
+            game.amounts[r] = GetAmount(instance, r);
+        }
+        for (int b = 0; b < BuildingCount(); b++) {
+            game.buildings[b].count = counts[b][instance];
+        }
+        game.gameTime = gameTimes[instance];
+
+        // Rates depend only on counts, so this reproduces the stored ones
+        game.RecalculateProduction();
+    }
+
+    // Copy a GameState into one instance
+    void StoreInstance(int instance, const GameState& game) {
+        for (int r = 0; r < kResourceCount; r++) {
+            mantissas[r][instance] = game.amounts[r].mantissa;
+            exponents[r][instance] = game.amounts[r].exponent;
+            rates[r][instance] = game.rates[r];
+        }
+        for (int b = 0; b < BuildingCount(); b++) {
+            counts[b][instance] = game.buildings[b].count;
+        }
+        gameTimes[instance] = game.gameTime;
+    }
+
+private:
+    // Columns
+    std::vector<double> mantissas[kResourceCount];
+    std::vector<int64_t> exponents[kResourceCount];
+    std::vector<double> rates[kResourceCount];
+    std::vector<std::vector<int>> counts;
+    std::vector<float> gameTimes;
+
+    // Content tables and purchase logic come from a real GameState
+    GameState scratch;
+
+    void TickRange(float deltaTime, int64_t begin, int64_t end) {
+        float* gameTime = gameTimes.data();
+        for (int64_t i = begin; i < end; i++) {
+            gameTime[i] += deltaTime;
+        }
+
+        for (int r = 0; r < kResourceCount; r++) {
+            double* mantissa = mantissas[r].data();
+            const int64_t* exponent = exponents[r].data();
+            const double* rate = rates[r].data();
+
+            // Fast path, branch-free so it vectorizes: ordinary amounts
+            // (exponent 0) are plain doubles, exactly as in BigNumber::operator+=
+            bool needsSlowPath = false;
+            for (int64_t i = begin; i < end; i++) {
+                double sum = mantissa[i] + rate[i] * deltaTime;
+                bool ordinary = exponent[i] == 0;
+                double updated = sum < 0.0 ? 0.0 : sum;
+                mantissa[i] = ordinary ? updated : mantissa[i];
+                needsSlowPath |= !ordinary | (std::fabs(updated) >= BigNumber::Scale());
+            }
+            if (!needsSlowPath) continue;
+
+            // Rare: late-game amounts or a value crossing into BigNumber range
+            for (int64_t i = begin; i < end; i++) {
+                if (exponent[i] == 0 && std::fabs(mantissa[i]) < BigNumber::Scale()) continue;
+
+                BigNumber value;
+                value.mantissa = mantissa[i];
+                value.exponent = exponent[i];
+                if (exponent[i] == 0) value.Normalize();
+                else value += rate[i] * deltaTime;
+                if (value.IsNegative()) value = BigNumber();
+
+                mantissa[i] = value.mantissa;
+                exponents[r][i] = value.exponent;
+            }
+        }
+    }
+};
@@ -0,0 +1,72 @@
+// Batched simulation throughput: instance-ticks/second against instance
+// count and thread count, with a one-GameState-per-instance baseline.
+#include <memory>
+#include <thread>
+#include "bench.h"
+#include "../batch.h"
+
+// Run the same ticks and purchases on a batch and on individual GameStates
+// and count instances that differ anywhere
+static int CountMismatches(int instanceCount, int ticks) {
+    BatchSimulation batch(instanceCount);
+    std::vector<GameState> games(instanceCount);
+
+    for (int t = 0; t < ticks; t++) {
+        float deltaTime = 1.0f / (30.0f + t % 40);
+        batch.Tick(deltaTime);
+        for (auto& game : games) game.Update(deltaTime);
+
+        // Different instances buy different things at different times
+        for (int i = 0; i < instanceCount; i++) {
+            if ((t + i) % 97 != 0) continue;
+            int building = (t * 7 + i) % batch.BuildingCount();
+            batch.PurchaseBuilding(i, building);
+            games[i].PurchaseBuilding(building);
+        }
+    }
+
+    int mismatches = 0;
+    for (int i = 0; i < instanceCount; i++) {
+        bool same = batch.GetCount(i, 0) == games[i].buildings[0].count;
+        for (int r = 0; r < kResourceCount; r++) {
+            BigNumber amount = batch.GetAmount(i, r);
+            same &= amount.mantissa == games[i].amounts[r].mantissa && amount.exponent == games[i].amounts[r].exponent;
+        }
+        for (int b = 0; b < batch.BuildingCount(); b++) same &= batch.GetCount(i, b) == games[i].buildings[b].count;
+        mismatches += !same;
+    }
+    return mismatches;
+}
+
+int main() {
+    printf("semantics check: %d mismatching instances of 2000 after 20000 ticks\n\n", CountMismatches(2000, 20000));
+
+    const int instanceCounts[] = { 1000, 10000, 100000, 1000000 };
+    std::vector<int> threadCounts = { 1 };
+    int hardwareThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int t = 2; t < hardwareThreads; t *= 2) threadCounts.push_back(t);
+    if (hardwareThreads > 1) threadCounts.push_back(hardwareThreads);
+
+    printf("%12s %8s %16s %16s\n", "instances", "threads", "ns/tick", "instance-ticks/s");
+    for (int instanceCount : instanceCounts) {
+        BatchSimulation batch(instanceCount);
+        int64_t ticks = std::max<int64_t>(10, 20000000 / instanceCount);
+
+        for (int threads : threadCounts) {
+            ThreadPool pool(threads);
+            BenchResult result = RunBenchmark(ticks, [&](int64_t) { batch.Tick(1.0f / 60.0f, pool); });
+            printf("%12d %8d %16.0f %16.3e\n", instanceCount, threads, result.nsPerOp, instanceCount / result.nsPerOp * 1e9);
+        }
+
+        // Baseline: one GameState per instance, ticked one at a time
+        if (instanceCount <= 100000) {
+            std::vector<GameState> games(instanceCount);
+            BenchResult result = RunBenchmark(ticks, [&](int64_t) {
+                for (auto& game : games) game.Update(1.0f / 60.0f);
+                });
+            printf("%12d %8s %16.0f %16.3e\n", instanceCount, "GameState", result.nsPerOp, instanceCount / result.nsPerOp * 1e9);
+        }
+        g_benchSink = batch.GetAmount(0, 0).mantissa;
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+// Shared harness for the headless benchmarks: timing, allocation counting
+// and a fixed-width report.
+//
+// Installs the allocation hook from alloccount.h, so it must be included by
+// exactly one translation unit per executable. Benchmarks are built with
+// INCREMENTAL_COUNT_ALLOCATIONS (see CMakeLists.txt).
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include "../alloccount.h"
+
+static_assert(kAllocationCountingEnabled, "benchmarks need INCREMENTAL_COUNT_ALLOCATIONS");
+
+INCREMENTAL_DEFINE_ALLOCATION_HOOK()
+
+// Keep results observable so the optimizer cannot drop benchmark loops
+inline volatile double g_benchSink;
+
+struct BenchResult {
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+// Time fn(i) for i in [0, iterations) and count heap allocations it makes
+template <typename Fn>
+BenchResult RunBenchmark(int64_t iterations, Fn&& fn) {
+    AllocationScope allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < iterations; i++) fn(i);
+    auto end = std::chrono::steady_clock::now();
+
+    BenchResult result;
+    result.nsPerOp = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    result.allocsPerOp = (double)allocations.Count() / iterations;
+    return result;
+}
+
+inline void PrintBenchHeader() {
+    printf("%-36s %12s %12s\n", "benchmark", "ns/op", "allocs/op");
+}
+
+inline void PrintBenchResult(const char* name, const BenchResult& result) {
+    printf("%-36s %12.2f %12.3f\n", name, result.nsPerOp, result.allocsPerOp);
+}
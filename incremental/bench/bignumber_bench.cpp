@@ -0,0 +1,108 @@
+// Micro-benchmark: BigNumber against plain double for the Update tick and
+// the core arithmetic it relies on.
+//
+// Both ticks are called through a volatile pointer, so every iteration loads
+// and stores the state the way the game's once-a-frame tick does; otherwise
+// the optimizer keeps the double reference in registers across the whole
+// loop. While amounts stay in double range GameState::Update takes its
+// plain double path (about 1.5x the reference, the cost of the exponent
+// checks); the general BigNumber path is about 4x. The benchmark fails if
+// the ordinary tick costs more than kMaxTickRatio times the reference.
+#include "bench.h"
+#include "../game.h"
+
+static const double kMaxTickRatio = 2.5;
+
+#ifdef NDEBUG
+static const char* kBuildConfiguration = "optimized (NDEBUG)";
+#else
+static const char* kBuildConfiguration = "debug";
+#endif
+
+// GameState::Update with double amounts, for reference: the same profiler
+// zone, clock, change counters and clamp, so the difference is the BigNumber
+// arithmetic
+struct DoubleTick {
+    double amounts[kResourceCount] = { 10.0, 10.0, 5.0, 0.0 };
+    double rates[kResourceCount] = { 1.0, 0.5, 0.3, 0.1 };
+    uint64_t amountVersions[kResourceCount] = {};
+    float gameTime = 0.0f;
+
+    void Update(float deltaTime) {
+        PROFILE_ZONE("DoubleTick::Update");
+        gameTime += deltaTime;
+        for (int r = 0; r < kResourceCount; r++) {
+            amounts[r] += rates[r] * deltaTime;
+            if (rates[r] != 0.0) amountVersions[r]++;
+            if (amounts[r] < 0.0) amounts[r] = 0.0;
+        }
+    }
+};
+
+// Fastest of several runs, so a noisy neighbour does not fail the ratio check
+template <typename Fn>
+BenchResult BestOf(int runs, int64_t iterations, Fn&& fn) {
+    BenchResult best = RunBenchmark(iterations, fn);
+    for (int i = 1; i < runs; i++) {
+        BenchResult result = RunBenchmark(iterations, fn);
+        if (result.nsPerOp < best.nsPerOp) best = result;
+    }
+    return best;
+}
+
+int main() {
+    const int64_t iterations = 20000000;
+    const float deltaTime = 1.0f / 60.0f;
+    const int runs = 5;
+
+    PrintBenchHeader();
+
+    DoubleTick doubleTick;
+    DoubleTick* volatile doubleTarget = &doubleTick;
+    BenchResult doubleTickResult = BestOf(runs, iterations / runs, [&](int64_t) { doubleTarget->Update(deltaTime); });
+    g_benchSink = doubleTick.amounts[0];
+    PrintBenchResult("Update tick (double)", doubleTickResult);
+
+    GameState game;
+    GameState* volatile gameTarget = &game;
+    BenchResult bigTickResult = BestOf(runs, iterations / runs, [&](int64_t) { gameTarget->Update(deltaTime); });
+    g_benchSink = game.amounts[0].ToDouble();
+    PrintBenchResult("Update tick (BigNumber)", bigTickResult);
+
+    // Same tick with amounts far beyond double range
+    GameState lateGame;
+    GameState* volatile lateTarget = &lateGame;
+    for (int r = 0; r < kResourceCount; r++) lateGame.amounts[r] = BigNumber::Pow(10.0, 500.0);
+    BenchResult lateTickResult = BestOf(runs, iterations / runs, [&](int64_t) { lateTarget->Update(deltaTime); });
+    g_benchSink = lateGame.amounts[0].mantissa;
+    PrintBenchResult("Update tick (1e500 amounts)", lateTickResult);
+
+    // Individual operations
+    BigNumber big = BigNumber::Pow(10.0, 300.0);
+    BigNumber acc = 1.0;
+    PrintBenchResult("BigNumber add", RunBenchmark(iterations, [&](int64_t) { acc += big; }));
+    g_benchSink = acc.mantissa;
+
+    BigNumber product = 1.0;
+    BigNumber factor = 1.0000001;
+    PrintBenchResult("BigNumber mul", RunBenchmark(iterations, [&](int64_t) { product *= factor; }));
+    g_benchSink = product.mantissa;
+
+    int less = 0;
+    PrintBenchResult("BigNumber compare", RunBenchmark(iterations, [&](int64_t i) { less += acc < BigNumber((double)i); }));
+    g_benchSink = less;
+
+    double powSum = 0.0;
+    PrintBenchResult("BigNumber pow", RunBenchmark(iterations / 10, [&](int64_t i) { powSum += BigNumber::Pow(kCostScaling, (double)(i % 100000)).mantissa; }));
+    g_benchSink = powSum;
+
+    double tickRatio = bigTickResult.nsPerOp / doubleTickResult.nsPerOp;
+    printf("\n%s build: BigNumber tick %.1f ns (late game %.1f ns), %.2fx / %.2fx the double tick (target <= %.1fx)\n",
+        kBuildConfiguration, bigTickResult.nsPerOp, lateTickResult.nsPerOp,
+        tickRatio, lateTickResult.nsPerOp / doubleTickResult.nsPerOp, kMaxTickRatio);
+    if (tickRatio > kMaxTickRatio) {
+        printf("FAIL: the BigNumber tick is over %.1fx the double tick\n", kMaxTickRatio);
+        return 1;
+    }
+    return 0;
+}
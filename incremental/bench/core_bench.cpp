@@ -0,0 +1,85 @@
+// Tick-throughput benchmarks for the GameState hot paths. Reports ns/op
+// and heap allocations/op so regressions show up on CI, and fails if a
+// steady-state frame allocates.
+#include "bench.h"
+#include "../game.h"
+
+int main() {
+    const int64_t iterations = 5000000;
+
+    PrintBenchHeader();
+
+    GameState game;
+    PrintBenchResult("GameState::Update", RunBenchmark(iterations, [&](int64_t) { game.Update(1.0f / 60.0f); }));
+    g_benchSink = game.amounts[0].ToDouble();
+
+    PrintBenchResult("GameState::RecalculateProduction", RunBenchmark(iterations, [&](int64_t) { game.RecalculateProduction(); }));
+    g_benchSink = game.rates[0];
+
+    int affordable = 0;
+    PrintBenchResult("GameState::CanAfford", RunBenchmark(iterations, [&](int64_t i) { affordable += game.CanAfford((int)(i % game.buildings.size())); }));
+    g_benchSink = affordable;
+
+    double costSum = 0.0;
+    PrintBenchResult("Building::GetNextCost", RunBenchmark(iterations, [&](int64_t i) {
+        costSum += game.buildings[i % game.buildings.size()].GetNextCost()[ResourceType::Wood].mantissa;
+        }));
+    g_benchSink = costSum;
+
+    // What every query paid before the cost was cached per count
+    PrintBenchResult("Building::GetNextCost (uncached)", RunBenchmark(iterations, [&](int64_t i) {
+        Building& building = game.buildings[i % game.buildings.size()];
+        building.InvalidateCost();
+        costSum += building.GetNextCost()[ResourceType::Wood].mantissa;
+        }));
+    g_benchSink = costSum;
+
+    double waitSum = 0.0;
+    PrintBenchResult("GameState::TimeUntilAffordable", RunBenchmark(iterations, [&](int64_t i) {
+        waitSum += game.TimeUntilAffordable((int)(i % game.buildings.size()));
+        }));
+    g_benchSink = waitSum;
+
+    // A steady-state frame: tick, then the per-building queries the UI and
+    // auto-buyers make. Must not touch the heap.
+    GameState steady;
+    BenchResult frame = RunBenchmark(iterations / 10, [&](int64_t) {
+        steady.Update(1.0f / 60.0f);
+        for (int b = 0; b < (int)steady.buildings.size(); b++) {
+            affordable += steady.CanAfford(b);
+            waitSum += steady.TimeUntilAffordable(b);
+        }
+        });
+    PrintBenchResult("steady-state frame", frame);
+    g_benchSink = affordable + waitSum;
+
+    // Purchases with an effectively unlimited stockpile, so every call succeeds
+    // and building counts (and costs) keep climbing
+    GameState rich;
+    for (int r = 0; r < kResourceCount; r++) rich.amounts[r] = BigNumber(1.0, 1000);
+    int purchased = 0;
+    PrintBenchResult("GameState::PurchaseBuilding", RunBenchmark(iterations / 5, [&](int64_t i) { purchased += rich.PurchaseBuilding((int)(i % rich.buildings.size())); }));
+    g_benchSink = purchased;
+
+    GameState bulk;
+    for (int r = 0; r < kResourceCount; r++) bulk.amounts[r] = BigNumber(1.0, 1000);
+    PrintBenchResult("GameState::PurchaseBuildings (x100)", RunBenchmark(iterations / 50, [&](int64_t i) { purchased += bulk.PurchaseBuildings((int)(i % bulk.buildings.size()), 100); }));
+    g_benchSink = purchased;
+
+    int maxCount = 0;
+    PrintBenchResult("GameState::MaxAffordable", RunBenchmark(iterations / 5, [&](int64_t i) { maxCount += bulk.MaxAffordable((int)(i % bulk.buildings.size())); }));
+    g_benchSink = maxCount;
+
+    // Includes constructing a fresh GameState per session
+    PrintBenchResult("GameState::Advance (8h, auto-buy)", RunBenchmark(200, [&](int64_t) {
+        GameState session;
+        session.Advance(8 * 3600.0, { 0, 1, 2, 3, 4 });
+        g_benchSink = session.amounts[0].mantissa;
+        }));
+
+    if (frame.allocsPerOp != 0.0) {
+        printf("\nsteady-state frame allocated\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Definition loading: parsing the text source versus mapping the compiled
+// cache, across content sizes, plus installing the result into a game.
+#include <filesystem>
+#include "bench.h"
+#include "../definitions.h"
+
+static std::string MakeSource(int buildingCount) {
+    std::string text =
+        "[resource Food]\namount = 10\nrate = 1.0\n\n"
+        "[resource Wood]\namount = 10\nrate = 0.5\n\n"
+        "[resource Stone]\namount = 5\nrate = 0.3\n\n"
+        "[resource Gold]\namount = 0\nrate = 0.1\n\n";
+    const char* names[] = { "Food", "Wood", "Stone", "Gold" };
+    for (int b = 0; b < buildingCount; b++) {
+        text += "[building Building " + std::to_string(b) + "]\n";
+        text += "description = Generated building number " + std::to_string(b) + "\n";
+        text += std::string("cost.") + names[b % 4] + " = " + std::to_string(10 + b) + "\n";
+        text += std::string("cost.") + names[(b + 1) % 4] + " = " + std::to_string(5 + b / 2) + "\n";
+        text += std::string("produces.") + names[(b + 2) % 4] + " = " + std::to_string(0.5 + b * 0.01) + "\n\n";
+    }
+    return text;
+}
+
+static bool SameDefinitions(const Definitions& a, const Definitions& b) {
+    for (int r = 0; r < kResourceCount; r++) {
+        if (a.resources[r].name != b.resources[r].name || a.resources[r].amount != b.resources[r].amount
+            || a.resources[r].baseRate != b.resources[r].baseRate) return false;
+    }
+    if (a.buildingTypes.size() != b.buildingTypes.size()) return false;
+    for (size_t i = 0; i < a.buildingTypes.size(); i++) {
+        const BuildingType& x = a.buildingTypes[i];
+        const BuildingType& y = b.buildingTypes[i];
+        if (x.name != y.name || x.description != y.description || x.baseCount != y.baseCount) return false;
+        if (x.globalBonus != y.globalBonus || x.globalMultiplier != y.globalMultiplier || x.costGrowth != y.costGrowth) return false;
+        for (int r = 0; r < kResourceCount; r++) {
+            if (x.cost[r] != y.cost[r] || x.production[r] != y.production[r]) return false;
+            if (x.bonus[r] != y.bonus[r] || x.multiplier[r] != y.multiplier[r]) return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    auto directory = std::filesystem::temp_directory_path();
+    std::string sourcePath = (directory / "incremental_bench_definitions.ini").string();
+    std::string cachePath = (directory / "incremental_bench_definitions.cache").string();
+    const int buildingCounts[] = { 5, 100, 500, 5000 };
+
+    printf("%10s %12s %12s %12s %12s %12s %6s\n", "buildings", "source B", "parse us", "cold us", "cached us", "apply us", "ok");
+    for (int buildingCount : buildingCounts) {
+        std::string source = MakeSource(buildingCount);
+        FILE* file = fopen(sourcePath.c_str(), "wb");
+        fwrite(source.data(), 1, source.size(), file);
+        fclose(file);
+        int64_t iterations = buildingCount >= 5000 ? 20 : 200;
+
+        Definitions parsed;
+        bool ok = ParseDefinitions(source, parsed);
+        BenchResult parse = RunBenchmark(iterations, [&](int64_t) { ParseDefinitions(source, parsed); });
+
+        // First startup: no cache, so parse and compile
+        Definitions loaded;
+        BenchResult cold = RunBenchmark(iterations, [&](int64_t) {
+            std::filesystem::remove(cachePath);
+            ok &= LoadDefinitions(sourcePath, cachePath, loaded);
+            });
+
+        // Later startups map the compiled cache
+        BenchResult cached = RunBenchmark(iterations, [&](int64_t) { ok &= LoadDefinitions(sourcePath, cachePath, loaded); });
+        ok &= SameDefinitions(parsed, loaded);
+
+        GameState game;
+        BenchResult apply = RunBenchmark(iterations, [&](int64_t) { ApplyDefinitions(loaded, game, true); });
+        ok &= game.buildings.size() == (size_t)buildingCount;
+
+        printf("%10d %12zu %12.1f %12.1f %12.1f %12.1f %6s\n", buildingCount, source.size(),
+            parse.nsPerOp / 1000.0, cold.nsPerOp / 1000.0, cached.nsPerOp / 1000.0, apply.nsPerOp / 1000.0, ok ? "yes" : "NO");
+    }
+
+    std::filesystem::remove(sourcePath);
+    std::filesystem::remove(cachePath);
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Building list cost against the number of building types: a whole UI
+// frame (update, record, diff, null backend) with the list at rest and
+// while scrolling one row per frame, plus hit-testing through ListLayout
+// against scanning one button per building as the fixed grid used to.
+// Per-frame cost should not depend on the building count.
+#include "bench.h"
+#include "../definitions.h"
+#include "../ui.h"
+
+// Default resources plus `buildingCount` generated building types
+static Definitions MakeDefinitions(int buildingCount) {
+    GameState defaults;
+    Definitions definitions;
+    for (int r = 0; r < kResourceCount; r++) {
+        definitions.resources[r].name = defaults.resourceNames[r];
+        definitions.resources[r].amount = 100.0;
+        definitions.resources[r].baseRate = 1.0 + r;
+    }
+    for (int b = 0; b < buildingCount; b++) {
+        BuildingType type;
+        type.name = L"Building " + std::to_wstring(b);
+        type.cost[b % kResourceCount] = 20.0 + b * 3.0;
+        type.cost[(b + 1) % kResourceCount] = 10.0 + b;
+        type.production[(b + 2) % kResourceCount] = 0.05;
+        definitions.buildingTypes.push_back(type);
+    }
+    return definitions;
+}
+
+// Frames of a session with the mouse over the list, scrolling one row per
+// frame (down, then back up) if `scroll`
+static BenchResult RunFrames(GameState& game, int64_t frames, bool scroll) {
+    const float deltaTime = 1.0f / 60.0f;
+    UIManager ui;
+    ui.Initialize();
+    RenderList list;
+    Renderer renderer;
+    NullRenderBackend backend;
+
+    // Warm up: first frame builds widgets for the new content
+    ui.Update(deltaTime, game);
+    ui.Record(list, 1100, 700, 60);
+    renderer.Submit(list, 1100, 700, backend);
+    ui.HandleMouseMove(450, 380);
+
+    int direction = -120;
+    return RunBenchmark(frames, [&](int64_t) {
+        game.Update(deltaTime);
+        if (scroll) {
+            int firstRow = ui.buildingList.FirstRow();
+            ui.HandleMouseWheel(450, 380, direction);
+            if (ui.buildingList.FirstRow() == firstRow) direction = -direction;
+        }
+        ui.Update(deltaTime, game);
+        ui.Record(list, 1100, 700, 60);
+        renderer.Submit(list, 1100, 700, backend);
+        });
+}
+
+int main() {
+    const int buildingCounts[] = { 5, 100, 1000, 10000, 100000 };
+    const int64_t frames = 3000;
+    const int64_t hits = 1000000;
+
+    printf("%10s %16s %16s %14s %14s %10s\n", "buildings", "rest ns/frame", "scroll ns/frame", "hit-test ns", "scan ns", "same hits");
+    for (int buildingCount : buildingCounts) {
+        Definitions definitions = MakeDefinitions(buildingCount);
+        GameState game;
+        ApplyDefinitions(definitions, game, true);
+
+        BenchResult rest = RunFrames(game, frames, false);
+        BenchResult scrolling = RunFrames(game, frames, true);
+
+        // A button per building laid out like the list at row 0, as the
+        // fixed grid would need
+        ListLayout layout(RenderRect{ 400.0f, 350.0f, 500.0f, 300.0f }, 160.0f, 60.0f, 10.0f, 20.0f);
+        layout.SetItemCount(buildingCount);
+        std::vector<Button> buttons;
+        for (int i = 0; i < buildingCount; i++) {
+            int row = i / layout.Columns();
+            int column = i % layout.Columns();
+            buttons.push_back(Button(400.0f + column * layout.PitchX(), 350.0f + row * layout.PitchY(), 160.0f, 60.0f, L""));
+        }
+
+        auto point = [](int64_t i, int& x, int& y) {
+            x = 380 + (int)(i * 37 % 560);
+            y = 330 + (int)(i * 53 % 340);
+        };
+
+        bool same = true;
+        BenchResult indexed = RunBenchmark(hits, [&](int64_t i) {
+            int x, y;
+            point(i, x, y);
+            g_benchSink = layout.HitTest((float)x, (float)y);
+            });
+        BenchResult scan = RunBenchmark(std::max<int64_t>(100, hits / buildingCount), [&](int64_t i) {
+            int x, y;
+            point(i, x, y);
+            int found = -1;
+            for (int b = 0; b < buildingCount; b++) {
+                if (buttons[b].Contains(x, y)) {
+                    found = b;
+                    break;
+                }
+            }
+            // The scan also finds buttons below the viewport
+            if (found >= layout.VisibleEnd()) found = -1;
+            same &= found == layout.HitTest((float)x, (float)y);
+            g_benchSink = found;
+            });
+
+        printf("%10d %16.0f %16.0f %14.2f %14.2f %10s\n", buildingCount, rest.nsPerOp, scrolling.nsPerOp,
+            indexed.nsPerOp, scan.nsPerOp, same ? "yes" : "NO");
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Display number formatting: std::wstringstream with std::fixed and
+// std::setprecision (what the UI used to do) against numberformat.h, for
+// the kinds of values the UI shows. Checks that Full notation produces the
+// same text as the streams, and prints Compact samples.
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include "bench.h"
+#include "../numberformat.h"
+
+static std::wstring StreamText(const BigNumber& value, int decimals) {
+    std::wstringstream ss;
+    ss << std::fixed << std::setprecision(decimals) << value;
+    return ss.str();
+}
+
+static std::wstring FormatterText(const BigNumber& value, int decimals, NumberNotation notation) {
+    std::wstring text;
+    AppendNumber(text, FormatNumber(value, decimals, notation));
+    return text;
+}
+
+int main() {
+    // Stockpiles and rates as they appear over a game: mostly small, some
+    // large, a few far beyond double range
+    std::mt19937 random(19);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<BigNumber> values(4096);
+    for (auto& value : values) {
+        double roll = unit(random);
+        if (roll < 0.7) value = unit(random) * 1000.0;
+        else if (roll < 0.95) value = std::pow(10.0, unit(random) * 14.0);
+        else value = BigNumber::Pow(10.0, 80.0 + unit(random) * 1000.0);
+    }
+
+    const int64_t iterations = 2000000;
+    const int64_t mask = (int64_t)values.size() - 1;
+    PrintBenchHeader();
+
+    PrintBenchResult("wstringstream, 1 decimal", RunBenchmark(iterations, [&](int64_t i) {
+        std::wstringstream ss;
+        ss << L"Food: " << std::fixed << std::setprecision(1) << values[i & mask];
+        g_benchSink = (double)ss.str().size();
+        }));
+
+    std::wstring text;
+    text.reserve(64);
+    PrintBenchResult("FormatNumber full, reused string", RunBenchmark(iterations, [&](int64_t i) {
+        text.assign(L"Food: ");
+        AppendNumber(text, FormatNumber(values[i & mask], 1, NumberNotation::Full));
+        g_benchSink = (double)text.size();
+        }));
+
+    PrintBenchResult("FormatNumber compact, reused string", RunBenchmark(iterations, [&](int64_t i) {
+        text.assign(L"Food: ");
+        AppendNumber(text, FormatNumber(values[i & mask], 1, NumberNotation::Compact));
+        g_benchSink = (double)text.size();
+        }));
+
+    PrintBenchResult("wstringstream, integer", RunBenchmark(iterations, [&](int64_t i) {
+        std::wstringstream ss;
+        ss << L"FPS: " << (int)(i & 1023);
+        g_benchSink = (double)ss.str().size();
+        }));
+
+    PrintBenchResult("FormatInteger, reused string", RunBenchmark(iterations, [&](int64_t i) {
+        text.assign(L"FPS: ");
+        AppendNumber(text, FormatInteger(i & 1023));
+        g_benchSink = (double)text.size();
+        }));
+
+    // Full is a drop-in replacement for the streams
+    int mismatches = 0;
+    for (const BigNumber& value : values) {
+        for (int decimals = 0; decimals <= 2; decimals++) {
+            // The streams print every digit of a plain double; Full stops at 1e15
+            if (value.exponent == 0 && value.mantissa >= 1e15) continue;
+            if (StreamText(value, decimals) != FormatterText(value, decimals, NumberNotation::Full)) mismatches++;
+        }
+    }
+    printf("\nfull notation mismatches against streams: %d of %zu\n", mismatches, values.size() * 3);
+
+    printf("compact samples:");
+    const BigNumber samples[] = { 0.0, 12.34, 999.96, 1234.0, 45678.0, 4.5e6, 999999.0, 1.23e33, 1e36, BigNumber::Pow(10.0, 120.0) };
+    for (const BigNumber& sample : samples) {
+        NumberText formatted = FormatNumber(sample, 1, NumberNotation::Compact);
+        printf(" %.*s", formatted.length, formatted.chars);
+    }
+    printf("\n");
+    return mismatches == 0 ? 0 : 1;
+}
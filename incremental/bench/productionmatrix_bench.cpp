@@ -0,0 +1,192 @@
+// Sparse production matrix at 1000 building types x 64 resources, each
+// building producing and costing a few resources and some carrying
+// production modifiers: recomputing every rate with a map merged per
+// building (as RecalculateProduction once did), with dense tables, and with
+// the CSR products, against a purchase applied as a rank-1 update. Also
+// affordability checks, dense against sparse. Checks that rank-1 updates
+// stay within rounding of a full recompute and of the dense formula, and
+// that the built-in content gets GameState's rates.
+#include <map>
+#include <random>
+#include "bench.h"
+#include "../game.h"
+#include "../productionmatrix.h"
+
+constexpr int kBuildings = 1000;
+constexpr int kResources = 64;
+
+struct WideBuildingType {
+    std::vector<double> cost = std::vector<double>(kResources);
+    std::vector<double> production = std::vector<double>(kResources);
+    std::vector<double> bonus = std::vector<double>(kResources);
+    std::vector<double> multiplier = std::vector<double>(kResources);
+    double globalBonus = 0.0;
+    double globalMultiplier = 0.0;
+    double costGrowth = 1.15;
+};
+
+// One to three produced and costed resources per building; one in ten with
+// a bonus, one in twenty with a multiplier, one in a hundred global
+static std::vector<WideBuildingType> MakeTypes() {
+    std::mt19937 random(22);
+    std::uniform_int_distribution<int> resource(0, kResources - 1);
+    std::uniform_int_distribution<int> entries(1, 3);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    std::vector<WideBuildingType> types(kBuildings);
+    for (auto& type : types) {
+        for (int i = entries(random); i > 0; i--) type.production[resource(random)] = 0.05 + unit(random);
+        for (int i = entries(random); i > 0; i--) type.cost[resource(random)] = 10.0 + 100.0 * unit(random);
+        type.costGrowth = 1.05 + 0.2 * unit(random);
+        if (unit(random) < 0.1) type.bonus[resource(random)] = 0.05 * unit(random);
+        if (unit(random) < 0.05) type.multiplier[resource(random)] = 0.01 * unit(random);
+        if (unit(random) < 0.01) type.globalBonus = 0.02 * unit(random);
+        if (unit(random) < 0.01) type.globalMultiplier = 0.002 * unit(random);
+    }
+    return types;
+}
+
+// The ModifierGraph formula over dense tables
+static void DenseRates(const std::vector<WideBuildingType>& types, const std::vector<int>& counts,
+    const std::vector<double>& baseRates, std::vector<double>& rates) {
+    double flat[kResources], bonus[kResources] = {}, multiplier[kResources];
+    double globalBonus = 0.0, globalMultiplier = 1.0;
+    for (int r = 0; r < kResources; r++) {
+        flat[r] = baseRates[r];
+        multiplier[r] = 1.0;
+    }
+    for (int b = 0; b < kBuildings; b++) {
+        const WideBuildingType& type = types[b];
+        double count = counts[b];
+        for (int r = 0; r < kResources; r++) {
+            flat[r] += type.production[r] * count;
+            bonus[r] += type.bonus[r] * count;
+            if (type.multiplier[r] != 0.0) multiplier[r] *= std::pow(1.0 + type.multiplier[r], count);
+        }
+        globalBonus += type.globalBonus * count;
+        if (type.globalMultiplier != 0.0) globalMultiplier *= std::pow(1.0 + type.globalMultiplier, count);
+    }
+    for (int r = 0; r < kResources; r++) rates[r] = flat[r] * (1.0 + bonus[r] + globalBonus) * multiplier[r] * globalMultiplier;
+}
+
+static double MaxRelativeDifference(const double* a, const double* b, int count) {
+    double worst = 0.0;
+    for (int r = 0; r < count; r++) {
+        worst = std::max(worst, std::fabs(a[r] - b[r]) / std::max(1.0, std::fabs(b[r])));
+    }
+    return worst;
+}
+
+int main() {
+    std::vector<WideBuildingType> types = MakeTypes();
+    std::vector<double> baseRates(kResources, 0.5);
+
+    ProductionMatrix matrix;
+    matrix.Build(baseRates, types);
+
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> building(0, kBuildings - 1);
+    std::vector<int> counts(kBuildings);
+    for (int b = 0; b < kBuildings; b++) {
+        counts[b] = (int)(random() % 20);
+        matrix.SetCount(b, counts[b]);
+    }
+
+    printf("%d buildings x %d resources, %d production and %d cost entries (%.1f%% dense)\n\n", kBuildings, kResources,
+        matrix.Production().NonZeros(), matrix.Cost().NonZeros(),
+        100.0 * (matrix.Production().NonZeros() + matrix.Cost().NonZeros()) / (2.0 * kBuildings * kResources));
+
+    const int64_t recomputes = 2000;
+    const int64_t purchases = 2000000;
+    std::vector<double> rates(kResources);
+    PrintBenchHeader();
+
+    PrintBenchResult("recompute, map per building", RunBenchmark(recomputes, [&](int64_t) {
+        std::vector<double> flat(baseRates), bonus(kResources), multiplier(kResources, 1.0);
+        double globalBonus = 0.0, globalMultiplier = 1.0;
+        for (int b = 0; b < kBuildings; b++) {
+            const WideBuildingType& type = types[b];
+            std::map<int, double> production, bonuses, multipliers;
+            for (int r = 0; r < kResources; r++) {
+                if (type.production[r] > 0.0) production[r] = type.production[r] * counts[b];
+                if (type.bonus[r] > 0.0) bonuses[r] = type.bonus[r] * counts[b];
+                if (type.multiplier[r] > 0.0) multipliers[r] = std::pow(1.0 + type.multiplier[r], counts[b]);
+            }
+            for (const auto& entry : production) flat[entry.first] += entry.second;
+            for (const auto& entry : bonuses) bonus[entry.first] += entry.second;
+            for (const auto& entry : multipliers) multiplier[entry.first] *= entry.second;
+            globalBonus += type.globalBonus * counts[b];
+            globalMultiplier *= std::pow(1.0 + type.globalMultiplier, counts[b]);
+        }
+        for (int r = 0; r < kResources; r++) rates[r] = flat[r] * (1.0 + bonus[r] + globalBonus) * multiplier[r] * globalMultiplier;
+        g_benchSink = rates[0];
+        }));
+
+    PrintBenchResult("recompute, dense tables", RunBenchmark(recomputes, [&](int64_t) {
+        DenseRates(types, counts, baseRates, rates);
+        g_benchSink = rates[0];
+        }));
+
+    PrintBenchResult("recompute, CSR product", RunBenchmark(recomputes, [&](int64_t) {
+        matrix.Recompute();
+        g_benchSink = matrix.Rates()[0];
+        }));
+
+    PrintBenchResult("count change, rank-1 update", RunBenchmark(purchases, [&](int64_t i) {
+        int b = building(random);
+        matrix.SetCount(b, matrix.Count(b) + ((i & 1) ? 1 : -1) * (matrix.Count(b) > 0 ? 1 : -1));
+        g_benchSink = matrix.Rates()[0];
+        }));
+
+    std::vector<double> amounts(kResources, 500.0);
+    PrintBenchResult("can afford, dense tables", RunBenchmark(purchases, [&](int64_t i) {
+        int b = (int)(i % kBuildings);
+        const double* cost = types[b].cost.data();
+        double scale = std::pow(types[b].costGrowth, counts[b]);
+        bool affordable = true;
+        for (int r = 0; r < kResources; r++) affordable &= amounts[r] >= cost[r] * scale;
+        g_benchSink = affordable;
+        }));
+
+    PrintBenchResult("can afford, CSR", RunBenchmark(purchases, [&](int64_t i) {
+        g_benchSink = matrix.CanAfford((int)(i % kBuildings), amounts.data());
+        }));
+
+    // Rank-1 updates against a full product of the same counts
+    double drift = 0.0;
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 10000; i++) {
+            int b = building(random);
+            matrix.SetCount(b, (int)(random() % 50));
+        }
+        std::vector<double> incremental(matrix.Rates(), matrix.Rates() + kResources);
+        matrix.Recompute();
+        drift = std::max(drift, MaxRelativeDifference(incremental.data(), matrix.Rates(), kResources));
+    }
+
+    // The CSR products against the dense tables (ModifierGraph's resource
+    // masks stop at 32 resources, so it cannot check these directly)
+    for (int b = 0; b < kBuildings; b++) counts[b] = matrix.Count(b);
+    DenseRates(types, counts, baseRates, rates);
+    double error = MaxRelativeDifference(matrix.Rates(), rates.data(), kResources);
+
+    // The built-in content, whose House carries a global bonus
+    GameState game;
+    std::vector<double> gameBase(kResourceCount);
+    for (int r = 0; r < kResourceCount; r++) gameBase[r] = game.baseRates[r];
+    ProductionMatrix gameMatrix;
+    gameMatrix.Build(gameBase, game.buildingTypes);
+    for (int b = 0; b < (int)game.buildings.size(); b++) {
+        game.buildings[b].count = 3 + 2 * b;
+        gameMatrix.SetCount(b, game.buildings[b].count);
+    }
+    game.RecalculateProduction();
+    double gameRates[kResourceCount];
+    for (int r = 0; r < kResourceCount; r++) gameRates[r] = game.rates[r];
+    double gameError = MaxRelativeDifference(gameMatrix.Rates(), gameRates, kResourceCount);
+
+    printf("\nrank-1 drift against recompute: %.3g, CSR against dense: %.3g (%lld rank-1 updates, %lld recomputes)\n",
+        drift, error, (long long)matrix.rankOneUpdates, (long long)matrix.recomputes);
+    printf("built-in content against GameState: %.3g\n", gameError);
+    return drift < 1e-12 && error < 1e-12 && gameError < 1e-12 ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+// Profiler overhead: a zone and a counter with recording off and on, the
+// instrumented GameState::Update both ways, frame-time percentiles, and a
+// Chrome trace export with several threads recording at once.
+#include <filesystem>
+#include <thread>
+#include "bench.h"
+#include "../game.h"
+
+int main() {
+    const int64_t iterations = 10000000;
+    PrintBenchHeader();
+
+    Profiler::SetEnabled(false);
+    PrintBenchResult("zone, disabled", RunBenchmark(iterations, [&](int64_t) { PROFILE_ZONE("bench"); }));
+    PrintBenchResult("counter, disabled", RunBenchmark(iterations, [&](int64_t i) { PROFILE_COUNTER("bench", i); }));
+
+    GameState game;
+    PrintBenchResult("GameState::Update, disabled", RunBenchmark(iterations, [&](int64_t) { game.Update(1.0f / 60.0f); }));
+    g_benchSink = game.amounts[0].mantissa;
+
+    Profiler::SetEnabled(true);
+    PROFILE_ZONE("warm up");     // Creates this thread's buffer outside the timed loops
+    PrintBenchResult("zone, enabled", RunBenchmark(iterations, [&](int64_t) { PROFILE_ZONE("bench"); }));
+    PrintBenchResult("counter, enabled", RunBenchmark(iterations, [&](int64_t i) { PROFILE_COUNTER("bench", i); }));
+    PrintBenchResult("GameState::Update, enabled", RunBenchmark(iterations, [&](int64_t) { game.Update(1.0f / 60.0f); }));
+    g_benchSink = game.amounts[0].mantissa;
+
+    FrameTimeStats frames;
+    double percentiles = 0.0;
+    PrintBenchResult("frame stats add + p50 + p99", RunBenchmark(iterations / 10, [&](int64_t i) {
+        frames.Add((16.0 + (i % 7) * 0.3) / 1000.0);
+        percentiles += frames.PercentileMillis(0.5) + frames.PercentileMillis(0.99);
+        }));
+    g_benchSink = percentiles;
+
+    // Several threads fill their rings while the trace is written
+    std::vector<std::thread> threads;
+    std::atomic<bool> stop{ false };
+    for (int t = 0; t < 3; t++) {
+        threads.emplace_back([&, t]() {
+            const char* names[] = { "Worker A", "Worker B", "Worker C" };
+            Profiler::SetThreadName(names[t]);
+            GameState local;
+            while (!stop.load()) local.Update(1.0f / 60.0f);
+            });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::string path = (std::filesystem::temp_directory_path() / "incremental_profile.json").string();
+    bool written = false;
+    BenchResult write = RunBenchmark(1, [&](int64_t) { written = Profiler::Instance().WriteChromeTrace(path); });
+    stop = true;
+    for (auto& thread : threads) thread.join();
+    Profiler::SetEnabled(false);
+
+    uintmax_t size = written ? std::filesystem::file_size(path) : 0;
+    printf("\nchrome trace: %s, %.1f MB in %.1f ms\n", written ? path.c_str() : "FAILED", size / 1e6, write.nsPerOp / 1e6);
+    std::filesystem::remove(path);
+    return written ? 0 : 1;
+}
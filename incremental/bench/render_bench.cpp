@@ -0,0 +1,161 @@
+// Headless frame cost of the real UI: recording the render command list,
+// diffing it against the previous frame and "drawing" it with the null
+// backend. Compares redrawing only the changed regions with redrawing the
+// whole window every frame, as the old WM_PAINT path did.
+//
+// The null backend draws nothing, so it shows the Renderer's own overhead
+// only. The sweep below fills real pixels, clipped to the dirty regions the
+// way a GDI or Direct2D backend would, with a growing share of a grid of
+// cells changing each frame. It reports where redrawing only the changed
+// regions stops paying off, next to Renderer::kFullRedrawFraction.
+#include <cmath>
+#include "bench.h"
+#include "../ui.h"
+
+struct FrameStats {
+    BenchResult result;
+    double commandsPerFrame = 0.0;
+    double drawnPerFrame = 0.0;
+    double dirtyFraction = 0.0;
+    double drawCallsPerFrame = 0.0;
+};
+
+static FrameStats RunSession(bool fullRedraw, int64_t frames) {
+    const float deltaTime = 1.0f / 60.0f;
+    const int width = 1100;
+    const int height = 700;
+
+    GameState game;
+    UIManager ui;
+    ui.Initialize();
+    RenderList list;
+    Renderer renderer;
+    NullRenderBackend backend;
+
+    int64_t commands = 0;
+    double dirty = 0.0;
+
+    FrameStats stats;
+    stats.result = RunBenchmark(frames, [&](int64_t frame) {
+        game.Update(deltaTime);
+
+        // A player who clicks a gather button twice a second and tries a
+        // building every 5 seconds, moving the mouse between them
+        if (frame % 30 == 0) {
+            ui.HandleMouseMove(850, 120);
+            ui.HandleMouseDown(850, 120, game);
+            ui.HandleMouseUp();
+        }
+        if (frame % 300 == 150) {
+            ui.HandleMouseMove(450, 380);
+            ui.HandleMouseDown(450, 380, game);
+            ui.HandleMouseUp();
+        }
+
+        ui.Update(deltaTime, game);
+        ui.Record(list, width, height, 60);
+        if (fullRedraw) renderer.Invalidate();
+        renderer.Submit(list, width, height, backend);
+
+        commands += (int64_t)renderer.commandsRecorded;
+        dirty += renderer.dirtyFraction;
+        });
+
+    stats.commandsPerFrame = (double)commands / frames;
+    stats.drawnPerFrame = (double)backend.commandsDrawn / frames;
+    stats.drawCallsPerFrame = (double)backend.frames / frames;
+    stats.dirtyFraction = dirty / frames;
+    return stats;
+}
+
+// Fills each command's bounds into a frame buffer, clipped to the dirty
+// regions; text counts as a fill of its layout rect
+class FillRenderBackend : public RenderBackend {
+public:
+    std::vector<uint32_t> pixels;
+
+    void Draw(const RenderList& list, const std::vector<RenderRect>& dirty, int width, int height) override {
+        pixels.resize((size_t)width * height);
+        for (const auto& command : list.commands) {
+            RenderRect bounds = command.Bounds();
+            for (const auto& rect : dirty) {
+                int left = std::max(0, (int)std::max(bounds.x, rect.x));
+                int top = std::max(0, (int)std::max(bounds.y, rect.y));
+                int right = std::min(width, (int)std::ceil(std::min(bounds.Right(), rect.Right())));
+                int bottom = std::min(height, (int)std::ceil(std::min(bounds.Bottom(), rect.Bottom())));
+                for (int y = top; y < bottom; y++) {
+                    std::fill(pixels.begin() + (size_t)y * width + left, pixels.begin() + (size_t)y * width + right, command.color);
+                }
+            }
+        }
+    }
+};
+
+// A grid of labelled cells, the first `changed` of which show a new value
+// every frame
+static void RecordGrid(RenderList& list, int columns, int rows, int changed, int64_t frame, int width, int height) {
+    list.Clear();
+    float cellWidth = (float)width / columns;
+    float cellHeight = (float)height / rows;
+    list.FillRect(RenderRect{ 0.0f, 0.0f, (float)width, (float)height }, MakeColor(255, 30, 30, 40));
+    for (int cell = 0; cell < columns * rows; cell++) {
+        RenderRect rect{ (cell % columns) * cellWidth, (cell / columns) * cellHeight, cellWidth, cellHeight };
+        list.FillRect(rect, MakeColor(255, 60, 60, 80));
+        std::wstring label = std::to_wstring(cell < changed ? frame : 0);
+        list.Text(label, rect, RenderFont::Small, MakeColor(255, 230, 230, 230), TextAlign::Center);
+    }
+}
+
+static double GridFrameCost(int changed, bool fullRedraw, double fullRedrawFraction, int64_t frames) {
+    const int columns = 20, rows = 14, width = 1100, height = 700;
+    RenderList list;
+    Renderer renderer;
+    renderer.fullRedrawFraction = fullRedrawFraction;
+    FillRenderBackend backend;
+    RecordGrid(list, columns, rows, changed, 0, width, height);
+    renderer.Submit(list, width, height, backend);
+
+    // Fastest of a few runs: the fills are memory bound and noisy
+    double best = 0.0;
+    for (int run = 0; run < 3; run++) {
+        double nsPerFrame = RunBenchmark(frames, [&](int64_t frame) {
+            RecordGrid(list, columns, rows, changed, run * frames + frame + 1, width, height);
+            if (fullRedraw) renderer.Invalidate();
+            renderer.Submit(list, width, height, backend);
+            }).nsPerOp;
+        if (run == 0 || nsPerFrame < best) best = nsPerFrame;
+    }
+    return best;
+}
+
+int main() {
+    const int64_t frames = 60 * 60 * 10;
+
+    printf("%-22s %12s %12s %12s %14s %12s %12s\n", "mode", "ns/frame", "allocs/f", "recorded/f", "redrawn cmd/f", "dirty %", "draws/f");
+    const bool modes[] = { true, false };
+    for (bool fullRedraw : modes) {
+        FrameStats stats = RunSession(fullRedraw, frames);
+        printf("%-22s %12.0f %12.2f %12.1f %14.1f %12.1f %12.2f\n", fullRedraw ? "full redraw" : "changed regions only",
+            stats.result.nsPerOp, stats.result.allocsPerOp, stats.commandsPerFrame, stats.drawnPerFrame,
+            stats.dirtyFraction * 100.0, stats.drawCallsPerFrame);
+    }
+
+    // Changed share of the window against the cost of each way of drawing it
+    const int cells = 20 * 14;
+    const int64_t gridFrames = 200;
+    const double never = 2.0;
+    double crossover = -1.0;
+    printf("\n%-10s %14s %14s %14s\n", "changed %", "regions ns/f", "full ns/f", "renderer ns/f");
+    for (int step = 0; step <= 10; step++) {
+        int changed = cells * step / 10;
+        double regions = GridFrameCost(changed, false, never, gridFrames);
+        double full = GridFrameCost(changed, true, never, gridFrames);
+        double renderer = GridFrameCost(changed, false, Renderer::kFullRedrawFraction, gridFrames);
+        printf("%-10d %14.0f %14.0f %14.0f\n", step * 10, regions, full, renderer);
+        if (crossover < 0.0 && regions >= full) crossover = step / 10.0;
+    }
+    if (crossover < 0.0) printf("changed regions stay cheaper up to the whole window");
+    else printf("a full redraw is cheaper from about %.0f%% changed", crossover * 100.0);
+    printf("; Renderer::kFullRedrawFraction = %.0f%%\n", Renderer::kFullRedrawFraction * 100.0);
+    return 0;
+}
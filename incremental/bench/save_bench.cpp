@@ -0,0 +1,64 @@
+// Save/load latency for the binary save format across save sizes, plus the
+// main-thread cost of requesting an autosave.
+#include <filesystem>
+#include "bench.h"
+#include "../savegame.h"
+
+static SaveData MakeSave(size_t buildingCount) {
+    SaveData save;
+    save.gameTime = 123456.5;
+    for (int r = 0; r < kResourceCount; r++) save.amounts[r] = BigNumber(1.5 + r, r);
+    save.counts.resize(buildingCount);
+    for (size_t b = 0; b < buildingCount; b++) save.counts[b] = (int32_t)(b * 2654435761u % 1000);
+    return save;
+}
+
+int main() {
+    std::string path = (std::filesystem::temp_directory_path() / "incremental_bench.sav").string();
+    const size_t buildingCounts[] = { 5, 1000, 100000, 1000000, 16000000 };
+
+    printf("%12s %12s %12s %12s %12s %12s %6s\n", "buildings", "bytes", "encode us", "save us", "load us", "read us", "ok");
+    for (size_t buildingCount : buildingCounts) {
+        SaveData save = MakeSave(buildingCount);
+        int64_t iterations = buildingCount >= 1000000 ? 5 : 50;
+
+        std::vector<unsigned char> encoded;
+        BenchResult encode = RunBenchmark(iterations, [&](int64_t) { encoded = EncodeSave(save); });
+        BenchResult write = RunBenchmark(iterations, [&](int64_t) { WriteSave(path, save); });
+
+        // Map, validate (checksum) and expose the data in place
+        bool ok = true;
+        BenchResult load = RunBenchmark(iterations, [&](int64_t) {
+            LoadedSave loaded;
+            ok &= loaded.Open(path);
+            g_benchSink = loaded.GameTime();
+            });
+
+        // Touch every count through the mapping, as applying a save would
+        LoadedSave loaded;
+        ok &= loaded.Open(path);
+        BenchResult read = RunBenchmark(iterations, [&](int64_t) {
+            int64_t sum = 0;
+            for (uint32_t b = 0; b < loaded.BuildingCount(); b++) sum += loaded.Counts()[b];
+            g_benchSink = (double)sum;
+            });
+
+        ok &= loaded.BuildingCount() == buildingCount && loaded.GameTime() == save.gameTime;
+        for (size_t b = 0; ok && b < buildingCount; b++) ok &= loaded.Counts()[b] == save.counts[b];
+        for (int r = 0; r < kResourceCount; r++) ok &= loaded.Amount(r) == save.amounts[r];
+
+        printf("%12zu %12zu %12.1f %12.1f %12.1f %12.1f %6s\n", buildingCount, encoded.size(),
+            encode.nsPerOp / 1000.0, write.nsPerOp / 1000.0, load.nsPerOp / 1000.0, read.nsPerOp / 1000.0, ok ? "yes" : "NO");
+    }
+
+    // What the main loop pays for an autosave of the real game
+    GameState game;
+    AutosaveWorker autosave(path);
+    BenchResult request = RunBenchmark(1000, [&](int64_t) { autosave.RequestSave(game); });
+    autosave.Flush();
+    printf("\nAutosaveWorker::RequestSave: %.2f us on the calling thread (%.1f allocs), %llu files written\n",
+        request.nsPerOp / 1000.0, request.allocsPerOp, (unsigned long long)autosave.SavesWritten());
+
+    std::filesystem::remove(path);
+    return 0;
+}
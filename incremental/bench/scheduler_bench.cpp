@@ -0,0 +1,102 @@
+// Affordability tracking with many building types: polling CanAfford and
+// TimeUntilAffordable for every building each frame versus the event-driven
+// AffordabilityScheduler. Also checks that an auto-buyer driven by the
+// scheduler buys on exactly the same frames as a polling one.
+#include "bench.h"
+#include "../definitions.h"
+#include "../scheduler.h"
+
+// Default resources plus `buildingCount` generated building types
+static Definitions MakeDefinitions(int buildingCount) {
+    GameState defaults;
+    Definitions definitions;
+    for (int r = 0; r < kResourceCount; r++) {
+        definitions.resources[r].name = defaults.resourceNames[r];
+        definitions.resources[r].amount = 100.0;
+        definitions.resources[r].baseRate = 1.0 + r;
+    }
+    for (int b = 0; b < buildingCount; b++) {
+        BuildingType type;
+        type.name = L"Building " + std::to_wstring(b);
+        type.cost[b % kResourceCount] = 20.0 + b * 3.0;
+        type.cost[(b + 1) % kResourceCount] = 10.0 + b;
+        type.production[(b + 2) % kResourceCount] = 0.05;
+        definitions.buildingTypes.push_back(type);
+    }
+    return definitions;
+}
+
+int main() {
+    const int buildingCounts[] = { 5, 100, 500 };
+    const int64_t frames = 60 * 60 * 10;
+    const float deltaTime = 1.0f / 60.0f;
+
+    printf("%10s %14s %14s %14s %12s %12s\n", "buildings", "poll ns/frame", "sched ns/frame", "recomputes/f", "mismatches", "same buys");
+    for (int buildingCount : buildingCounts) {
+        Definitions definitions = MakeDefinitions(buildingCount);
+
+        // Both players gather now and then and auto-buy building 0 the
+        // moment it is affordable
+        auto gather = [](GameState& game, int64_t frame) {
+            if (frame % 120 == 0) game.GatherResource((ResourceType)(frame / 120 % kResourceCount), 25.0);
+        };
+
+        GameState polled;
+        ApplyDefinitions(definitions, polled, true);
+        std::vector<int64_t> polledBuys;
+        int affordableCount = 0;
+        double waitSum = 0.0;
+        BenchResult poll = RunBenchmark(frames, [&](int64_t frame) {
+            polled.Update(deltaTime);
+            gather(polled, frame);
+            while (polled.CanAfford(0)) {
+                polled.PurchaseBuilding(0);
+                polledBuys.push_back(frame);
+            }
+            // What a UI needs each frame: enabled state and time to ready
+            for (int b = 0; b < buildingCount; b++) {
+                affordableCount += polled.CanAfford(b);
+                waitSum += std::min(polled.TimeUntilAffordable(b), 1e9);
+            }
+            });
+        g_benchSink = affordableCount + waitSum;
+
+        GameState scheduled;
+        ApplyDefinitions(definitions, scheduled, true);
+        AffordabilityScheduler scheduler;
+        std::vector<int64_t> scheduledBuys;
+        int64_t mismatches = 0;
+        BenchResult schedule = RunBenchmark(frames, [&](int64_t frame) {
+            double now = (frame + 1) * (double)deltaTime;
+            scheduled.Update(deltaTime);
+            gather(scheduled, frame);
+            scheduler.Update(scheduled, now);
+            while (scheduler.IsAffordable(0)) {
+                scheduled.PurchaseBuilding(0);
+                scheduledBuys.push_back(frame);
+                scheduler.Update(scheduled, now);
+            }
+            });
+
+        // Verify against polling outside the timed loop
+        GameState check;
+        ApplyDefinitions(definitions, check, true);
+        AffordabilityScheduler checkScheduler;
+        for (int64_t frame = 0; frame < frames; frame++) {
+            double now = (frame + 1) * (double)deltaTime;
+            check.Update(deltaTime);
+            gather(check, frame);
+            checkScheduler.Update(check, now);
+            while (checkScheduler.IsAffordable(0)) {
+                check.PurchaseBuilding(0);
+                checkScheduler.Update(check, now);
+            }
+            for (int b = 0; b < buildingCount; b++) mismatches += checkScheduler.IsAffordable(b) != check.CanAfford(b);
+        }
+
+        printf("%10d %14.0f %14.0f %14.2f %12lld %12s\n", buildingCount, poll.nsPerOp, schedule.nsPerOp,
+            (double)scheduler.Recomputations() / frames, (long long)mismatches,
+            polledBuys == scheduledBuys ? "yes" : "NO");
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+// Lazy session store under a generated server load: request latency
+// percentiles, page traffic and memory per session, for tens of thousands
+// of players with only a fraction resident. Also checks that a lazily
+// evaluated session matches a GameState advanced eagerly between the same
+// requests.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include "bench.h"
+#include "../sessions.h"
+
+// Player requests arriving at a fixed rate. Player popularity is roughly
+// Zipf: rank k is picked with probability ~1/k, so a few players are hot
+// and most are cold, with ranks scattered across session ids.
+class LoadGenerator {
+public:
+    struct Request {
+        double time;
+        int session;
+        int action;         // 0: read stockpiles, 1: gather, 2: buy
+        int building;
+        ResourceType resource;
+    };
+
+    LoadGenerator(int sessionCount, double requestsPerSecond, uint32_t seed)
+        : sessionCount(sessionCount), interval(1.0 / requestsPerSecond), random(seed) {
+    }
+
+    Request Next() {
+        Request request;
+        time += interval;
+        request.time = time;
+        int rank = std::min(sessionCount - 1, (int)std::pow((double)sessionCount, unit(random)) - 1);
+        request.session = (int)((int64_t)rank * 2654435761u % sessionCount);
+        double roll = unit(random);
+        request.action = roll < 0.6 ? 0 : roll < 0.85 ? 1 : 2;
+        request.building = (int)(random() % 5);
+        request.resource = (ResourceType)(random() % kResourceCount);
+        return request;
+    }
+
+private:
+    int sessionCount;
+    double interval;
+    double time = 0.0;
+    std::mt19937 random;
+    std::uniform_real_distribution<double> unit{ 0.0, 1.0 };
+};
+
+static void Apply(SessionStore& store, const LoadGenerator::Request& request) {
+    if (request.action == 0) {
+        double sum = 0.0;
+        for (int r = 0; r < kResourceCount; r++) sum += store.GetAmount(request.session, r, request.time).ToDouble();
+        g_benchSink = sum;
+    }
+    else if (request.action == 1) {
+        store.GatherResource(request.session, request.resource, 5.0, request.time);
+    }
+    else {
+        store.PurchaseBuilding(request.session, request.building, request.time);
+    }
+}
+
+// Same requests on a store and on an eagerly advanced GameState per
+// session; counts sessions that differ anywhere
+static int CountMismatches(const std::string& pagePath) {
+    const int sessionCount = 2000;
+    GameState content;
+    SessionStore store(content, 200, pagePath);
+    std::vector<GameState> games(sessionCount);
+    std::vector<double> lastTimes(sessionCount, 0.0);
+    for (int s = 0; s < sessionCount; s++) store.CreateSession(0.0);
+
+    LoadGenerator load(sessionCount, 50.0, 3);
+    for (int i = 0; i < 200000; i++) {
+        LoadGenerator::Request request = load.Next();
+        Apply(store, request);
+
+        GameState& game = games[request.session];
+        game.AdvanceLinear(request.time - lastTimes[request.session]);
+        lastTimes[request.session] = request.time;
+        if (request.action == 1) game.GatherResource(request.resource, 5.0);
+        if (request.action == 2) game.PurchaseBuilding(request.building);
+    }
+
+    int mismatches = 0;
+    GameState loaded;
+    for (int s = 0; s < sessionCount; s++) {
+        store.Load(s, lastTimes[s], loaded);
+        bool same = loaded.gameTime == games[s].gameTime;
+        for (int r = 0; r < kResourceCount; r++) same &= loaded.amounts[r] == games[s].amounts[r];
+        for (size_t b = 0; b < loaded.buildings.size(); b++) same &= loaded.buildings[b].count == games[s].buildings[b].count;
+        mismatches += !same;
+    }
+    return mismatches;
+}
+
+static double Percentile(std::vector<double>& sorted, double p) {
+    return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+}
+
+int main() {
+    std::string pagePath = (std::filesystem::temp_directory_path() / "incremental_bench_sessions.page").string();
+    printf("semantics check: %d mismatching sessions of 2000 after 200000 requests\n\n", CountMismatches(pagePath));
+
+    struct Case {
+        int sessions;
+        int resident;
+    };
+    const Case cases[] = { { 10000, 10000 }, { 50000, 50000 }, { 50000, 5000 }, { 200000, 20000 }, { 200000, 2000 } };
+    const int64_t requests = 1000000;
+
+    // A full GameState per player, for comparison: the object, its building
+    // table and its copy of the content (type names and modifier graph not counted)
+    GameState content;
+    size_t gameStateBytes = sizeof(GameState) + content.buildings.capacity() * sizeof(Building)
+        + content.buildingTypes.capacity() * sizeof(BuildingType);
+
+    printf("%10s %10s %10s %10s %10s %10s %12s %12s %12s %10s\n", "sessions", "resident", "p50 ns", "p99 ns", "p99.9 ns",
+        "max us", "page-ins/s", "B/session", "B/resident", "allocs/op");
+    for (const Case& test : cases) {
+        SessionStore store(content, test.resident, pagePath);
+        for (int s = 0; s < test.sessions; s++) store.CreateSession(0.0);
+
+        // Warm up so the resident set reflects the access pattern
+        LoadGenerator load(test.sessions, 1000.0, 11);
+        for (int i = 0; i < test.sessions; i++) Apply(store, load.Next());
+        uint64_t pageInsBefore = store.PageIns();
+
+        std::vector<double> latencies(requests);
+        AllocationScope allocations;
+        auto start = std::chrono::steady_clock::now();
+        for (int64_t i = 0; i < requests; i++) {
+            LoadGenerator::Request request = load.Next();
+            auto begin = std::chrono::steady_clock::now();
+            Apply(store, request);
+            latencies[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double allocsPerOp = (double)allocations.Count() / requests;
+
+        std::sort(latencies.begin(), latencies.end());
+        printf("%10d %10d %10.0f %10.0f %10.0f %10.1f %12.0f %12.1f %12.1f %10.3f\n", test.sessions, test.resident,
+            Percentile(latencies, 0.5), Percentile(latencies, 0.99), Percentile(latencies, 0.999), latencies.back() / 1000.0,
+            (store.PageIns() - pageInsBefore) / seconds, (double)store.MemoryBytes() / test.sessions,
+            (double)store.MemoryBytes() / store.ResidentCount(), allocsPerOp);
+        if (store.PageFailures() > 0) printf("  %llu page failures\n", (unsigned long long)store.PageFailures());
+    }
+    printf("\npage record: %zu bytes; a GameState per player: at least %zu bytes\n", SessionStore(content, 1, pagePath).RecordBytes(), gameStateBytes);
+    return 0;
+}
@@ -0,0 +1,169 @@
+// Fixed-timestep simulation thread: cost of the lock-free handoffs (input
+// queue, snapshot publish and acquire), then a live run with a render loop
+// reading snapshots as fast as it can while clicking. Checks that the
+// renderer never saw a torn snapshot, that no tick allocated, and that the
+// recorded session replays to the same state. Last, an auto-clicker
+// flooding the gather buttons through the UI, with a purchase click every
+// frame: every click must arrive, and with gathers merged on the UI the
+// input queue must stay far from full.
+#include <thread>
+#include "bench.h"
+#include "../simulation.h"
+#include "../ui.h"
+
+// Clicks as fast as one thread can for `seconds`, with a UI frame every
+// millisecond, then waits until every click has been applied
+static bool RunAutoClicker(double hz, double seconds) {
+    // Per frame the UI sends at most a gather per resource on each side of
+    // the purchase; a quarter of the queue leaves room for a late tick
+    const size_t queueCapacity = 1024;
+    const int64_t maxDepth = queueCapacity / 4;
+
+    GameState game;
+    CommandLog log;
+    log.Begin(game);
+    SimulationThread simulation(game, hz, &log, queueCapacity);
+    UIManager ui;
+    ui.Initialize();
+    ui.simulation = &simulation;
+    simulation.Start();
+
+    int64_t clicks = 0, purchaseClicks = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration<double>(seconds);
+    auto nextFrame = start;
+    while (std::chrono::steady_clock::now() < end) {
+        bool frame = std::chrono::steady_clock::now() >= nextFrame;
+        if (frame) {
+            ui.HandleBuildingButtonClick(0, game);
+            purchaseClicks++;
+        }
+        else {
+            ui.HandleGatherButtonClick((int)(clicks % kResourceCount), game);
+        }
+        clicks++;
+        if (frame) {
+            ui.Update(0.001f, simulation.AcquireSnapshot().game);
+            nextFrame += std::chrono::milliseconds(1);
+        }
+    }
+    double clickSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Drain: deferred clicks, then whatever is still queued
+    while (ui.HasPendingCommands()) {
+        ui.Update(0.001f, simulation.AcquireSnapshot().game);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(4.0 / hz));
+    simulation.Stop();
+    SimulationStats stats = simulation.AcquireSnapshot().stats;
+
+    int64_t applied = 0, gatherRecords = 0, purchases = 0;
+    for (const Command& command : log.commands) {
+        if (command.type == CommandType::Purchase) purchases++;
+        if (command.type != CommandType::Gather) continue;
+        applied += command.count;
+        gatherRecords++;
+    }
+
+    printf("\nauto-clicker: %.0f Hz simulation, %.1f s of clicking\n", hz, clickSeconds);
+    printf("  clicks                %10lld (%.0f per second)\n", (long long)clicks, clicks / clickSeconds);
+    printf("  clicks applied        %10lld (%lld of %lld purchases)\n", (long long)(applied + purchases),
+        (long long)purchases, (long long)purchaseClicks);
+    printf("  deferred by the UI    %10lld (queue full %lld times)\n", (long long)ui.clicksDeferred, (long long)stats.commandsRejected);
+    printf("  commands dequeued     %10lld (results dropped %lld)\n", (long long)stats.commandsApplied,
+        (long long)stats.resultsDropped);
+    printf("  gather batches        %10lld (%lld commands coalesced, %lld log records)\n",
+        (long long)stats.gatherBatches, (long long)stats.gathersCoalesced, (long long)gatherRecords);
+    printf("  queue depth avg / max %10.1f / %lld (limit %lld)\n", stats.averageQueueDepth,
+        (long long)stats.maxQueueDepth, (long long)maxDepth);
+    printf("  tick us avg / max     %10.2f / %.2f\n", stats.averageTickMicros, stats.maxTickMicros);
+    return applied + purchases == clicks && purchases == purchaseClicks && stats.maxQueueDepth <= maxDepth;
+}
+
+int main() {
+    PrintBenchHeader();
+
+    SpscQueue<Command> queue(1024);
+    Command popped{};
+    PrintBenchResult("queue push + pop", RunBenchmark(10000000, [&](int64_t i) {
+        queue.Push(Command::Purchase((int)(i & 3)));
+        queue.Pop(popped);
+        }));
+    g_benchSink = popped.index;
+
+    GameState source;
+    TripleBuffer<SimulationSnapshot> buffer;
+    for (auto& snapshot : buffer.buffers) MirrorGameState(source, snapshot.game, true);
+    PrintBenchResult("snapshot publish", RunBenchmark(1000000, [&](int64_t) {
+        source.Update(1.0f / 60.0f);
+        MirrorGameState(source, buffer.Back().game);
+        buffer.Publish();
+        }));
+    PrintBenchResult("snapshot acquire", RunBenchmark(1000000, [&](int64_t i) {
+        if (i % 2 == 0) buffer.Publish();
+        buffer.Acquire();
+        g_benchSink = buffer.Front().game.amounts[0].mantissa;
+        }));
+
+    // Live run: 240 Hz simulation, render loop reading snapshots flat out
+    const double hz = 240.0;
+    const double seconds = 2.0;
+    GameState game;
+    CommandLog log;
+    log.mergeTicks = false;
+    log.Begin(game);
+
+    SimulationThread simulation(game, hz, &log);
+    simulation.Start();
+
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration<double>(seconds);
+    int64_t frames = 0, torn = 0, submitted = 0, results = 0;
+    double maxAcquireNs = 0.0;
+    int64_t lastTicks = -1;
+    while (std::chrono::steady_clock::now() < end) {
+        auto acquireStart = std::chrono::steady_clock::now();
+        SimulationSnapshot& snapshot = simulation.AcquireSnapshot();
+        double acquireNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - acquireStart).count();
+        maxAcquireNs = std::max(maxAcquireNs, acquireNs);
+        frames++;
+
+        // Every field of a snapshot comes from the same tick
+        if (snapshot.time != snapshot.stats.ticks / hz) torn++;
+        if (snapshot.stats.ticks < lastTicks) torn++;
+        lastTicks = snapshot.stats.ticks;
+
+        if (frames % 2000 == 0) {
+            int b = (int)(frames / 2000 % 3);
+            submitted += simulation.Submit(frames % 4000 == 0 ? Command::Purchase(b) : Command::Gather((ResourceType)b, 5.0));
+        }
+        Command result;
+        while (simulation.PollResult(result)) results++;
+    }
+    simulation.Stop();
+    SimulationSnapshot& last = simulation.AcquireSnapshot();
+    SimulationStats stats = last.stats;
+
+    GameState replayed;
+    ReplayResult replay = CommandReplay::Run(log, replayed, ReplayMode::Exact);
+    bool same = replay.divergences == 0;
+    for (int r = 0; r < kResourceCount; r++) same &= replayed.amounts[r] == game.amounts[r];
+    for (size_t b = 0; b < game.buildings.size(); b++) same &= replayed.buildings[b].count == game.buildings[b].count;
+
+    printf("\nlive run: %.0f Hz target for %.1f s\n", hz, seconds);
+    printf("  measured Hz           %10.1f\n", stats.measuredHz);
+    printf("  ticks                 %10lld\n", (long long)stats.ticks);
+    printf("  tick us avg / max     %10.2f / %.2f\n", stats.averageTickMicros, stats.maxTickMicros);
+    printf("  wake late us avg / max%10.1f / %.1f\n", stats.averageWakeLateMicros, stats.maxWakeLateMicros);
+    printf("  catch-up ticks        %10lld\n", (long long)stats.catchUpTicks);
+    printf("  dropped seconds       %10.3f\n", stats.droppedSeconds);
+    printf("  render frames         %10lld (max acquire %.0f ns)\n", (long long)frames, maxAcquireNs);
+    printf("  commands submitted    %10lld (results %lld, rejected %lld, results dropped %lld)\n",
+        (long long)submitted, (long long)results, (long long)stats.commandsRejected, (long long)stats.resultsDropped);
+    printf("  allocating ticks      %10lld\n", (long long)stats.allocatingTicks);
+    printf("  torn snapshots        %10lld\n", (long long)torn);
+    printf("  replay matches        %10s\n", same ? "yes" : "NO");
+    bool autoClickerPassed = RunAutoClicker(60.0, 1.0);
+    return torn == 0 && same && stats.allocatingTicks == 0 && autoClickerPassed ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+// Autosave snapshots over one hour of play, saving every 5 seconds with two
+// purchases between saves: bytes written per hour as full saves against
+// deltas with compaction, the cost of writing a snapshot, and restore
+// latency for the newest snapshot against loading a full save. Every
+// snapshot is restored right after it is written and compared with what
+// was saved.
+#include <filesystem>
+#include <random>
+#include "bench.h"
+#include "../snapshots.h"
+
+static bool SameSave(const SaveData& a, const SaveData& b) {
+    if (a.gameTime != b.gameTime || a.counts != b.counts || a.buildingNames != b.buildingNames) return false;
+    for (int r = 0; r < kResourceCount; r++) {
+        if (a.amounts[r].mantissa != b.amounts[r].mantissa || a.amounts[r].exponent != b.amounts[r].exponent) return false;
+    }
+    return true;
+}
+
+int main() {
+    const size_t buildingCounts[] = { 5, 1000, 100000 };
+    const double saveInterval = 5.0;
+    const int savesPerHour = (int)(3600.0 / saveInterval);
+    const int purchasesPerSave = 2;
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "incremental_bench_snapshots";
+
+    printf("%10s %14s %14s %8s %7s %7s %6s %11s %12s %12s %6s\n", "buildings", "full B/hour", "delta B/hour", "ratio",
+        "fulls", "deltas", "files", "write us", "restore us", "load us", "ok");
+    for (size_t buildingCount : buildingCounts) {
+        std::filesystem::remove_all(directory);
+        SnapshotStore store(directory.string());
+        bool ok = store.Open();
+
+        std::mt19937 random(23);
+        SaveData save;
+        save.counts.assign(buildingCount, 0);
+        for (size_t b = 0; b < buildingCount; b++) save.counts[b] = (int32_t)(random() % 10);
+        for (size_t b = 0; b < buildingCount; b++) save.buildingNames.push_back(BuildingNameHash(L"Building " + std::to_wstring(b)));
+        for (int r = 0; r < kResourceCount; r++) save.amounts[r] = BigNumber(100.0 * (r + 1));
+
+        uint64_t fullBytes = 0;
+        double writeSeconds = 0.0;
+        for (int s = 0; s < savesPerHour; s++) {
+            save.gameTime += saveInterval;
+            for (int r = 0; r < kResourceCount; r++) save.amounts[r] += BigNumber(saveInterval * (r + 1));
+            for (int p = 0; p < purchasesPerSave; p++) save.counts[random() % buildingCount]++;
+            fullBytes += EncodeSave(save).size();
+
+            auto start = std::chrono::steady_clock::now();
+            ok &= store.Write(save);
+            writeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            SaveData restored;
+            ok &= store.Restore(store.LastSequence(), restored) && SameSave(restored, save);
+        }
+
+        SaveData latest;
+        BenchResult restore = RunBenchmark(200, [&](int64_t) {
+            ok &= store.RestoreLatest(latest);
+            g_benchSink = latest.gameTime;
+            });
+        ok &= SameSave(latest, save);
+
+        std::string fullPath = (directory / "full.sav").string();
+        ok &= WriteSave(fullPath, save);
+        BenchResult load = RunBenchmark(200, [&](int64_t) {
+            LoadedSave loaded;
+            ok &= loaded.Open(fullPath);
+            SaveData data = loaded.ToSaveData();
+            g_benchSink = data.gameTime;
+            });
+        std::filesystem::remove(fullPath);
+
+        printf("%10zu %14llu %14llu %8.1f %7llu %7llu %6zu %11.1f %12.1f %12.1f %6s\n", buildingCount,
+            (unsigned long long)fullBytes, (unsigned long long)store.BytesWritten(),
+            (double)fullBytes / std::max<uint64_t>(1, store.BytesWritten()),
+            (unsigned long long)store.FullWrites(), (unsigned long long)store.DeltaWrites(), store.Sequences().size(),
+            writeSeconds * 1e6 / savesPerHour, restore.nsPerOp / 1000.0, load.nsPerOp / 1000.0, ok ? "yes" : "NO");
+        if (!ok) return 1;
+    }
+
+    std::filesystem::remove_all(directory);
+    return 0;
+}
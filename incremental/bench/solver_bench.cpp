@@ -0,0 +1,42 @@
+// Build-order solver throughput: nodes/second and speedup against thread
+// count for a few representative goals.
+#include <thread>
+#include "bench.h"
+#include "../solver.h"
+
+struct SolverCase {
+    const char* name;
+    SolverGoal goal;
+    int maxPurchases;
+};
+
+int main() {
+    const SolverCase cases[] = {
+        { "first Mine", SolverGoal::Building(3), 12 },
+        { "3 Mines", SolverGoal::Building(3, 3), 14 },
+        { "1e4 Gold", SolverGoal::Resource(ResourceType::Gold, 1e4), 16 },
+        { "1e5 Gold", SolverGoal::Resource(ResourceType::Gold, 1e5), 24 },
+    };
+
+    std::vector<int> threadCounts = { 1 };
+    int hardwareThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int t = 2; t < hardwareThreads; t *= 2) threadCounts.push_back(t);
+    if (hardwareThreads > 1) threadCounts.push_back(hardwareThreads);
+
+    GameState game;
+    printf("%-12s %8s %12s %12s %10s %14s %8s\n", "goal", "threads", "time (s)", "nodes", "wall (ms)", "nodes/s", "speedup");
+    for (const auto& solverCase : cases) {
+        double singleThreadWall = 0.0;
+        for (int threads : threadCounts) {
+            ThreadPool pool(threads);
+            BuildOrderSolver solver(game, solverCase.goal, solverCase.maxPurchases);
+            SolverResult result = solver.Solve(pool);
+            if (threads == 1) singleThreadWall = result.wallSeconds;
+
+            printf("%-12s %8d %12.2f %12lld %10.1f %14.0f %8.2f\n", solverCase.name, threads, result.time,
+                (long long)result.nodesExpanded, result.wallSeconds * 1000.0, result.NodesPerSecond(),
+                singleThreadWall / std::max(result.wallSeconds, 1e-9));
+        }
+    }
+    return 0;
+}
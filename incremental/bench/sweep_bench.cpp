@@ -0,0 +1,104 @@
+// Balance sweep throughput: simulated hours per wall-clock minute against
+// thread count, for a 24 hour run per combination of cost growth and food
+// rate. Checks that every thread count writes the same rows (in any order),
+// and that the scripted player ends where GameState::Advance with every
+// building on auto-purchase does.
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include "bench.h"
+#include "../sweep.h"
+
+// Run a sweep into a temporary file; returns the rows sorted by run index
+static std::vector<std::string> RunSweep(SweepRunner& runner, ThreadPool& pool, double& wallSeconds) {
+    FILE* file = tmpfile();
+    SweepCsvWriter writer(file);
+
+    auto start = std::chrono::steady_clock::now();
+    runner.Run(pool, writer);
+    wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string text;
+    long size = ftell(file);
+    text.resize(size);
+    rewind(file);
+    if (fread(&text[0], 1, size, file) != (size_t)size) text.clear();
+    fclose(file);
+
+    std::vector<std::string> rows;
+    std::istringstream lines(text);
+    for (std::string line; std::getline(lines, line);) rows.push_back(line);
+    std::sort(rows.begin(), rows.end(), [](const std::string& a, const std::string& b) {
+        return atoll(a.c_str()) < atoll(b.c_str());
+        });
+    return rows;
+}
+
+int main() {
+    Definitions content = CaptureDefinitions(GameState());
+
+    std::vector<SweepParameter> parameters(2);
+    ParseSweepParameter("growth=1.05:1.3:32", content, parameters[0]);
+    ParseSweepParameter("rate.Food=0.5:2:32", content, parameters[1]);
+
+    SweepSettings settings;
+    settings.seconds = 24.0 * 3600.0;
+    settings.sampleInterval = 3600.0;
+    settings.milestones = { { (int)ResourceType::Gold, 1e6 } };
+
+    std::vector<int> threadCounts = { 1 };
+    int hardwareThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int t = 2; t < hardwareThreads; t *= 2) threadCounts.push_back(t);
+    if (hardwareThreads > 1) threadCounts.push_back(hardwareThreads);
+
+    printf("%8s %8s %10s %12s %22s %8s %10s\n", "threads", "runs", "wall (ms)", "runs/s", "simulated hours/min", "speedup", "same rows");
+    std::vector<std::string> reference;
+    double singleThreadWall = 0.0;
+    for (int threads : threadCounts) {
+        ThreadPool pool(threads);
+        SweepRunner runner(content, parameters, settings);
+        double wall = 0.0;
+        std::vector<std::string> rows = RunSweep(runner, pool, wall);
+        if (threads == 1) {
+            singleThreadWall = wall;
+            reference = rows;
+        }
+
+        printf("%8d %8lld %10.1f %12.0f %22.3g %8.2f %10s\n", threads, (long long)runner.RunsCompleted(), wall * 1000.0,
+            runner.RunsCompleted() / wall, runner.SimulatedHours() * 60.0 / wall, singleThreadWall / std::max(wall, 1e-9),
+            rows == reference ? "yes" : "NO");
+    }
+
+    // The scripted player against Advance, for a spread of combinations
+    SweepRunner runner(content, parameters, settings);
+    std::vector<int> everyBuilding;
+    for (int b = 0; b < (int)content.buildingTypes.size(); b++) everyBuilding.push_back(b);
+
+    int mismatches = 0;
+    int checked = 0;
+    std::vector<double> values;
+    for (int64_t index = 0; index < runner.CombinationCount(); index += 37) {
+        runner.Combination(index, values);
+        Definitions variant = content;
+        for (size_t p = 0; p < parameters.size(); p++) parameters[p].Apply(values[p], variant);
+
+        GameState scripted;
+        ApplyDefinitions(variant, scripted, true);
+        SweepRun run;
+        RunScriptedPlayer(scripted, settings, run);
+
+        GameState advanced;
+        ApplyDefinitions(variant, advanced, true);
+        int purchases = advanced.Advance(settings.seconds, everyBuilding);
+
+        bool same = purchases == run.purchases;
+        for (int r = 0; r < kResourceCount; r++) {
+            double expected = advanced.amounts[r].ToDouble();
+            same &= std::fabs(scripted.amounts[r].ToDouble() - expected) <= 1e-9 * std::max(1.0, std::fabs(expected));
+        }
+        mismatches += same ? 0 : 1;
+        checked++;
+    }
+    printf("\nscripted player mismatches against Advance: %d of %d\n", mismatches, checked);
+    return mismatches == 0 && !reference.empty() ? 0 : 1;
+}
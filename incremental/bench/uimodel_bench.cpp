@@ -0,0 +1,112 @@
+// Per-frame UI text cost: rebuilding every label, cost string and enabled
+// flag each frame (the old UIManager behaviour) versus the dirty-tracked
+// UIModel, over the same simulated 60 FPS session.
+#include <iomanip>
+#include <sstream>
+#include "bench.h"
+#include "../uimodel.h"
+
+// What UIManager used to do every frame
+struct NaiveUI {
+    std::wstring resources[kResourceCount];
+    std::wstring production;
+    std::vector<std::wstring> labels;
+    std::vector<std::wstring> costs;
+    std::vector<bool> enabled;
+
+    void Update(const GameState& game) {
+        labels.resize(game.buildings.size());
+        costs.resize(game.buildings.size());
+        enabled.resize(game.buildings.size());
+
+        for (int r = 0; r < kResourceCount; r++) {
+            std::wstringstream ss;
+            ss << game.resourceNames[r] << L": " << std::fixed << std::setprecision(1) << game.amounts[r];
+            resources[r] = ss.str();
+        }
+
+        std::wstringstream prod;
+        prod << L"Production/sec:";
+        for (int r = 0; r < kResourceCount; r++) {
+            prod << L"\n  " << game.resourceNames[r] << L": +" << std::fixed << std::setprecision(1) << game.rates[r];
+        }
+        production = prod.str();
+
+        for (size_t i = 0; i < game.buildings.size(); i++) {
+            const Building& building = game.buildings[i];
+            enabled[i] = game.CanAfford((int)i);
+
+            std::wstringstream label;
+            label << building.type->name << L" (" << building.count << L")";
+            labels[i] = label.str();
+
+            auto cost = building.GetNextCost();
+            std::wstringstream costStream;
+            costStream << L"Cost: ";
+            bool first = true;
+            for (int r = 0; r < kResourceCount; r++) {
+                if (cost[r] <= 0.0) continue;
+                if (!first) costStream << L", ";
+                first = false;
+                costStream << game.resourceNames[r].substr(0, 1) << L":" << std::fixed << std::setprecision(0) << cost[r];
+            }
+            costs[i] = costStream.str();
+        }
+    }
+};
+
+static bool SameText(const NaiveUI& naive, const UIModel& model) {
+    for (int r = 0; r < kResourceCount; r++) {
+        if (naive.resources[r] != model.resources[r].text) return false;
+    }
+    if (naive.production != model.productionText) return false;
+    for (size_t i = 0; i < naive.labels.size(); i++) {
+        const auto& widget = model.buildings[i];
+        if (naive.labels[i] != widget.label || naive.costs[i] != widget.costText || naive.enabled[i] != widget.affordable) return false;
+    }
+    return true;
+}
+
+int main() {
+    const int64_t frames = 60 * 60 * 10;    // Ten minutes at 60 FPS
+    const float deltaTime = 1.0f / 60.0f;
+
+    // A player who buys whatever is affordable every 5 seconds
+    auto step = [&](GameState& game, int64_t frame) {
+        game.Update(deltaTime);
+        if (frame % 300 == 0) {
+            for (int i = 0; i < (int)game.buildings.size(); i++) game.PurchaseBuilding(i);
+        }
+    };
+
+    PrintBenchHeader();
+
+    GameState naiveGame;
+    NaiveUI naive;
+    BenchResult naiveResult = RunBenchmark(frames, [&](int64_t frame) {
+        step(naiveGame, frame);
+        naive.Update(naiveGame);
+        });
+    PrintBenchResult("full rebuild per frame", naiveResult);
+
+    GameState modelGame;
+    UIModel model;
+    model.SetNotation(NumberNotation::Full);    // The old text, for the comparison below
+    int64_t recomputed = 0;
+    BenchResult modelResult = RunBenchmark(frames, [&](int64_t frame) {
+        step(modelGame, frame);
+        model.BeginFrame();
+        model.Update(modelGame, (frame + 1) * (double)deltaTime);
+        recomputed += model.RecomputedLastFrame();
+        });
+    PrintBenchResult("UIModel (dirty tracked)", modelResult);
+
+    // Baseline: the simulation alone
+    GameState plainGame;
+    PrintBenchResult("simulation only", RunBenchmark(frames, [&](int64_t frame) { step(plainGame, frame); }));
+
+    int widgetCount = kResourceCount + 1 + 2 * (int)modelGame.buildings.size();
+    printf("\nwidgets: %d, recomputed per frame: %.2f on average\n", widgetCount, (double)recomputed / frames);
+    printf("text matches full rebuild: %s\n", SameText(naive, model) ? "yes" : "NO");
+    return 0;
+}
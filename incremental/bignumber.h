@@ -0,0 +1,176 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <iomanip>
+
+// Arbitrary-magnitude number for late-game resource amounts and costs.
+//
+// Stored as mantissa * 2^(kExponentBits * exponent). Values below 2^256
+// (about 1.16e77) keep exponent 0 and are plain doubles, so the common case
+// of add/compare costs one extra branch over double arithmetic. Above that
+// the mantissa is rescaled by exact powers of two, which never loses
+// precision, and the exponent carries the rest of the magnitude.
+struct BigNumber {
+    static constexpr int kExponentBits = 256;
+
+    double mantissa;    // |mantissa| < 2^256, and >= 1 whenever exponent > 0
+    int64_t exponent;   // Never negative; 0 for all ordinary values
+
+    BigNumber() : mantissa(0.0), exponent(0) {}
+    BigNumber(double value) : mantissa(value), exponent(0) { Normalize(); }
+    BigNumber(double m, int64_t e) : mantissa(m), exponent(e) { Normalize(); }
+
+    static double Scale() { return 0x1p256; }
+    static double InverseScale() { return 0x1p-256; }
+
+    // Bring the mantissa back into range after an arithmetic operation
+    void Normalize() {
+        while (std::fabs(mantissa) >= Scale()) {
+            if (std::isinf(mantissa) || std::isnan(mantissa)) return;
+            mantissa *= InverseScale();
+            exponent++;
+        }
+        while (exponent > 0 && std::fabs(mantissa) < 1.0) {
+            if (mantissa == 0.0) {
+                exponent = 0;
+                return;
+            }
+            mantissa *= Scale();
+            exponent--;
+        }
+    }
+
+    // b^p, computed in log space so it cannot overflow
+    static BigNumber Pow(double base, double power) {
+        double log2Value = power * std::log2(base);
+        if (log2Value < kExponentBits) return BigNumber(std::exp2(log2Value));
+
+        int64_t e = (int64_t)std::floor(log2Value / kExponentBits);
+        return BigNumber(std::exp2(log2Value - (double)e * kExponentBits), e);
+    }
+
+    // Nearest double; infinity once the value exceeds double range
+    double ToDouble() const {
+        if (exponent == 0) return mantissa;
+        if (exponent > 4) return mantissa < 0.0 ? -INFINITY : INFINITY;
+        return std::ldexp(mantissa, (int)(exponent * kExponentBits));
+    }
+
+    // log10 of the absolute value
+    double Log10() const {
+        return std::log10(std::fabs(mantissa)) + (double)exponent * kExponentBits * 0.30102999566398120;
+    }
+
+    bool IsZero() const { return mantissa == 0.0; }
+    bool IsNegative() const { return mantissa < 0.0; }
+
+    BigNumber operator-() const {
+        BigNumber result;
+        result.mantissa = -mantissa;
+        result.exponent = exponent;
+        return result;
+    }
+
+    BigNumber& operator+=(const BigNumber& other) {
+        if (exponent == other.exponent) {
+            mantissa += other.mantissa;
+        }
+        else if (exponent > other.exponent) {
+            // Anything two or more steps smaller is below double precision
+            if (exponent - other.exponent == 1) mantissa += other.mantissa * InverseScale();
+        }
+        else {
+            double m = other.exponent - exponent == 1 ? mantissa * InverseScale() : 0.0;
+            mantissa = other.mantissa + m;
+            exponent = other.exponent;
+        }
+
+        // Fast path: ordinary values stay ordinary
+        if (exponent == 0 && std::fabs(mantissa) < Scale()) return *this;
+        Normalize();
+        return *this;
+    }
+
+    // Adding a plain double (e.g. rate * deltaTime) is the per-tick hot path
+    BigNumber& operator+=(double value) {
+        if (exponent == 0) {
+            mantissa += value;
+            if (std::fabs(mantissa) < Scale()) return *this;
+            Normalize();
+            return *this;
+        }
+        return *this += BigNumber(value);
+    }
+
+    BigNumber& operator-=(const BigNumber& other) { return *this += -other; }
+
+    BigNumber& operator*=(const BigNumber& other) {
+        mantissa *= other.mantissa;
+        exponent += other.exponent;
+        if (exponent == 0 && std::fabs(mantissa) < Scale()) return *this;
+        Normalize();
+        return *this;
+    }
+
+    BigNumber& operator/=(const BigNumber& other) {
+        mantissa /= other.mantissa;
+        exponent -= other.exponent;
+
+        // Results below 1 with a negative exponent are far below any
+        // quantity the game tracks; fold them back into a plain double
+        if (exponent < 0) {
+            mantissa = std::ldexp(mantissa, (int)std::max<int64_t>(exponent * kExponentBits, -2000));
+            exponent = 0;
+        }
+        Normalize();
+        return *this;
+    }
+
+    friend BigNumber operator+(BigNumber a, const BigNumber& b) { return a += b; }
+    friend BigNumber operator-(BigNumber a, const BigNumber& b) { return a -= b; }
+    friend BigNumber operator*(BigNumber a, const BigNumber& b) { return a *= b; }
+    friend BigNumber operator/(BigNumber a, const BigNumber& b) { return a /= b; }
+
+    // Three-way comparison: negative, zero or positive
+    static int Compare(const BigNumber& a, const BigNumber& b) {
+        if (a.exponent == b.exponent) {
+            return a.mantissa < b.mantissa ? -1 : (a.mantissa > b.mantissa ? 1 : 0);
+        }
+
+        // Different exponents: the sign decides first, then magnitude
+        bool aNegative = a.mantissa < 0.0;
+        bool bNegative = b.mantissa < 0.0;
+        if (aNegative != bNegative) return aNegative ? -1 : 1;
+
+        int magnitude = a.exponent < b.exponent ? -1 : 1;
+        return aNegative ? -magnitude : magnitude;
+    }
+
+    friend bool operator<(const BigNumber& a, const BigNumber& b) { return Compare(a, b) < 0; }
+    friend bool operator<=(const BigNumber& a, const BigNumber& b) { return Compare(a, b) <= 0; }
+    friend bool operator>(const BigNumber& a, const BigNumber& b) { return Compare(a, b) > 0; }
+    friend bool operator>=(const BigNumber& a, const BigNumber& b) { return Compare(a, b) >= 0; }
+    friend bool operator==(const BigNumber& a, const BigNumber& b) { return Compare(a, b) == 0; }
+    friend bool operator!=(const BigNumber& a, const BigNumber& b) { return Compare(a, b) != 0; }
+
+    // Ordinary values print like a double (honouring the stream's format
+    // flags); larger ones print in scientific notation, e.g. 1.23e1000
+    template <typename CharT>
+    friend std::basic_ostream<CharT>& operator<<(std::basic_ostream<CharT>& out, const BigNumber& value) {
+        if (value.exponent == 0) return out << value.mantissa;
+
+        double log10Value = value.Log10();
+        double decimalExponent = std::floor(log10Value);
+        double decimalMantissa = std::pow(10.0, log10Value - decimalExponent);
+        std::ios_base::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        if (value.mantissa < 0.0) out << (CharT)'-';
+        out << std::fixed << std::setprecision(2) << decimalMantissa << (CharT)'e'
+            << std::setprecision(0) << decimalExponent;
+        out.flags(flags);
+        out.precision(precision);
+        return out;
+    }
+};
\ No newline at end of file
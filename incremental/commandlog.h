@@ -0,0 +1,295 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "game.h"
+#include "savegame.h"
+
+// Everything that changes a GameState goes through a Command, so a session
+// can be recorded and replayed.
+enum class CommandType : uint8_t {
+    Tick,       // Advance time: value = seconds, count = frames merged into this record
+                // (0 for a closed-form jump with no frames)
+    Gather,     // Manual gathering: index = ResourceType, value = amount
+    Purchase    // Buy buildings: index = building, count = how many
+};
+
+struct Command {
+    double time;            // Session time when issued (seconds since the log started)
+    double value;
+    int32_t index;
+    int32_t count;
+    CommandType type;
+    uint8_t succeeded;      // Outcome in the recorded session (purchases can fail)
+    uint8_t reserved[6];
+
+    // One frame of GameState::Update
+    static Command Tick(float deltaTime) {
+        return Make(CommandType::Tick, deltaTime, 0, 1);
+    }
+
+    // A closed-form jump, as GameState::AdvanceLinear
+    static Command Advance(double seconds) {
+        return Make(CommandType::Tick, seconds, 0, 0);
+    }
+
+    // `clicks` counts the clicks merged into one gather (SimulationThread
+    // coalesces them); replay only uses the amount
+    static Command Gather(ResourceType type, double amount, int clicks = 1) {
+        return Make(CommandType::Gather, amount, (int32_t)type, clicks);
+    }
+
+    static Command Purchase(int buildingIndex, int count = 1) {
+        return Make(CommandType::Purchase, 0.0, buildingIndex, count);
+    }
+
+private:
+    static Command Make(CommandType type, double value, int32_t index, int32_t count) {
+        Command command = {};
+        command.type = type;
+        command.value = value;
+        command.index = index;
+        command.count = count;
+        command.succeeded = 1;
+        return command;
+    }
+};
+static_assert(sizeof(Command) == 32, "Command layout is part of the log format");
+
+// Run one command against a game. A single-frame tick is exactly
+// GameState::Update; merged ticks are integrated in closed form.
+inline bool ApplyCommand(GameState& game, const Command& command) {
+    switch (command.type) {
+    case CommandType::Tick:
+        if (command.count == 1) game.Update((float)command.value);
+        else game.AdvanceLinear(command.value);
+        return true;
+    case CommandType::Gather:
+        if (command.index < 0 || command.index >= kResourceCount) return false;
+        game.GatherResource((ResourceType)command.index, command.value);
+        return true;
+    case CommandType::Purchase:
+        if (command.count == 1) return game.PurchaseBuilding(command.index);
+        return game.PurchaseBuildings(command.index, command.count);
+    }
+    return false;
+}
+
+// Command log file
+//
+//   CommandLogHeader                 fixed 40 bytes
+//   initial save                     EncodeSave() of the starting state
+//   Command[commandCount]            32 bytes each
+//
+// The checksum covers everything after the header.
+const uint32_t kCommandLogMagic = 0x4c434e49;     // "INCL"
+const uint32_t kCommandLogVersion = 1;
+
+struct CommandLogHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t reserved;
+    uint64_t initialSaveSize;
+    uint64_t commandCount;
+    uint64_t checksum;
+};
+static_assert(sizeof(CommandLogHeader) == 40, "CommandLogHeader layout is part of the log format");
+
+// Recorded session: the starting state plus every command after it.
+// The log keeps the session clock, advanced by the ticks it records, and
+// stamps each command with it.
+class CommandLog {
+public:
+    SaveData initialState;
+    std::vector<Command> commands;
+    double sessionTime = 0.0;
+
+    // Consecutive ticks with no input in between are merged into one record
+    // by default, so an idle hour costs one entry instead of 216,000. Turn
+    // off to keep every frame for bit-exact replays.
+    bool mergeTicks = true;
+
+    void Begin(const GameState& game) {
+        initialState = CaptureSave(game);
+        commands.clear();
+        sessionTime = 0.0;
+    }
+
+    void Record(Command command) {
+        command.time = sessionTime;
+        if (command.type == CommandType::Tick) sessionTime += command.value;
+
+        if (mergeTicks && command.type == CommandType::Tick && !commands.empty()) {
+            Command& last = commands.back();
+            if (last.type == CommandType::Tick && last.count != 0 && command.count != 0) {
+                last.value += command.value;
+                last.count += command.count;
+                return;
+            }
+        }
+        commands.push_back(command);
+    }
+
+    // Apply a command and record it with its outcome
+    bool Execute(GameState& game, Command command) {
+        command.succeeded = ApplyCommand(game, command) ? 1 : 0;
+        Record(command);
+        return command.succeeded != 0;
+    }
+
+    bool Save(const std::string& path) const {
+        std::vector<unsigned char> save = EncodeSave(initialState);
+        size_t commandBytes = commands.size() * sizeof(Command);
+        std::vector<unsigned char> buffer(sizeof(CommandLogHeader) + save.size() + commandBytes);
+
+        unsigned char* body = buffer.data() + sizeof(CommandLogHeader);
+        memcpy(body, save.data(), save.size());
+        if (commandBytes) memcpy(body + save.size(), commands.data(), commandBytes);
+
+        CommandLogHeader header = {};
+        header.magic = kCommandLogMagic;
+        header.version = kCommandLogVersion;
+        header.headerSize = sizeof(CommandLogHeader);
+        header.initialSaveSize = save.size();
+        header.commandCount = commands.size();
+        header.checksum = SaveChecksum(body, save.size() + commandBytes);
+        memcpy(buffer.data(), &header, sizeof(header));
+
+        return WriteFileAtomic(path, buffer.data(), buffer.size());
+    }
+
+    bool Load(const std::string& path) {
+        MappedFile file;
+        if (!file.Open(path) || file.Size() < sizeof(CommandLogHeader)) return false;
+
+        CommandLogHeader header;
+        memcpy(&header, file.Data(), sizeof(header));
+        if (header.magic != kCommandLogMagic || header.version != kCommandLogVersion) return false;
+        if (header.headerSize != sizeof(CommandLogHeader) || header.initialSaveSize % 8 != 0) return false;
+
+        // Bound each size by what the file holds before multiplying, so a
+        // forged header cannot wrap the sum
+        uint64_t available = file.Size() - sizeof(CommandLogHeader);
+        if (header.initialSaveSize > available) return false;
+        if (header.commandCount > (available - header.initialSaveSize) / sizeof(Command)) return false;
+        uint64_t bodySize = header.initialSaveSize + header.commandCount * sizeof(Command);
+
+        const unsigned char* body = file.Data() + sizeof(CommandLogHeader);
+        if (SaveChecksum(body, bodySize) != header.checksum) return false;
+
+        LoadedSave save;
+        if (!save.Validate(body, header.initialSaveSize)) return false;
+        initialState = save.ToSaveData();
+        sessionTime = 0.0;
+
+        commands.resize(header.commandCount);
+        if (header.commandCount) memcpy(commands.data(), body + header.initialSaveSize, header.commandCount * sizeof(Command));
+        for (const Command& command : commands) {
+            if (command.type == CommandType::Tick) sessionTime += command.value;
+        }
+        return true;
+    }
+};
+
+enum class ReplayMode {
+    Exact,      // Apply every command as recorded; bit-exact for logs recorded with mergeTicks off
+    Collapsed   // Integrate each run of ticks in one closed-form step
+};
+
+struct ReplayResult {
+    int64_t commandsApplied = 0;
+    int64_t framesReplayed = 0;         // Frames covered by tick records
+    int64_t tickSteps = 0;              // Tick steps actually executed
+    int64_t resyncs = 0;                // Purchases nudged across a rounding boundary
+    int64_t divergences = 0;            // Outcomes that differ from the recording
+    double simulatedSeconds = 0.0;
+    double wallSeconds = 0.0;
+
+    double SpeedupOverRealTime() const { return wallSeconds > 0.0 ? simulatedSeconds / wallSeconds : 0.0; }
+};
+
+// Re-runs a recorded session. Idle time between inputs is the bulk of any
+// real session, so Collapsed mode folds every run of ticks into a single
+// GameState::AdvanceLinear call and replays in O(inputs).
+//
+// Collapsed integration rounds differently from per-frame Update (relative
+// difference around 1e-14 over a 4 hour session), so a purchase recorded as
+// successful can land a hair short. Shortfalls within kResyncTolerance are topped up
+// and counted as resyncs; anything larger is reported as a divergence. The
+// same holds in Exact mode once a merged tick record (count != 1) has been
+// integrated, since that record no longer holds the frames as played.
+class CommandReplay {
+public:
+    static constexpr double kResyncTolerance = 1e-9;
+
+    static ReplayResult Run(const CommandLog& log, GameState& game, ReplayMode mode) {
+        auto start = std::chrono::steady_clock::now();
+        ReplayResult result;
+        ApplySaveData(log.initialState, game);
+
+        double pendingSeconds = 0.0;
+        bool integrated = mode == ReplayMode::Collapsed;
+        for (const Command& command : log.commands) {
+            result.commandsApplied++;
+
+            if (command.type == CommandType::Tick) {
+                result.framesReplayed += command.count;
+                result.simulatedSeconds += command.value;
+                if (mode == ReplayMode::Collapsed) {
+                    pendingSeconds += command.value;
+                    continue;
+                }
+                ApplyCommand(game, command);
+                result.tickSteps++;
+                integrated |= command.count != 1;
+                continue;
+            }
+
+            if (pendingSeconds > 0.0) {
+                game.AdvanceLinear(pendingSeconds);
+                pendingSeconds = 0.0;
+                result.tickSteps++;
+            }
+
+            if (integrated && command.type == CommandType::Purchase && command.succeeded) {
+                if (Resync(game, command)) result.resyncs++;
+            }
+
+            bool succeeded = ApplyCommand(game, command);
+            if (succeeded != (command.succeeded != 0)) result.divergences++;
+        }
+
+        if (pendingSeconds > 0.0) {
+            game.AdvanceLinear(pendingSeconds);
+            result.tickSteps++;
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        result.wallSeconds = std::chrono::duration<double>(end - start).count();
+        return result;
+    }
+
+private:
+    // Top up resources that fall short of a recorded purchase by rounding only
+    static bool Resync(GameState& game, const Command& command) {
+        if (command.index < 0 || command.index >= (int)game.buildings.size()) return false;
+        ResourceAmounts cost = game.buildings[command.index].GetBulkCost(command.count);
+
+        bool adjusted = false;
+        for (int r = 0; r < kResourceCount; r++) {
+            if (game.amounts[r] >= cost[r]) continue;
+            if (cost[r] - game.amounts[r] > cost[r] * kResyncTolerance) return false;
+            adjusted = true;
+        }
+        for (int r = 0; r < kResourceCount && adjusted; r++) {
+            if (game.amounts[r] >= cost[r]) continue;
+            game.amounts[r] = cost[r];
+            game.amountVersions[r]++;
+            game.adjustmentVersions[r]++;
+        }
+        return adjusted;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,593 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "game.h"
+#include "savegame.h"
+
+// Game content loaded from a definition file instead of code.
+//
+// The source is an INI-style text file that designers edit:
+//
+//   # Resources fill the ResourceType slots in order
+//   [resource Food]
+//   amount = 10              # starting stockpile
+//   rate = 1.0               # production per second with no buildings
+//
+//   [building Farm]
+//   description = Produces food
+//   cost.Wood = 10
+//   produces.Food = 2
+//   count = 0                # how many a new game starts with
+//   growth = 1.15            # cost multiplier per building owned (default 1.15)
+//
+//   [building House]
+//   bonus = 0.1              # +10% to every resource, per building
+//   bonus.Food = 0.05        # +5% to one resource
+//   multiplier.Gold = 0.02   # x1.02 to one resource, compounding
+//   multiplier = 0.01        # x1.01 to every resource, compounding
+//
+// Comments run from # or ; to the end of the line, except in descriptions,
+// which take the rest of the line as written.
+// The set of resources is fixed by ResourceType, so the file must define
+// exactly kResourceCount of them; it chooses their names, starting amounts
+// and base rates. Buildings are unlimited and keep the order of the file.
+//
+// Parsing happens once: the result is compiled into a binary cache next to
+// the source, which later startups map and copy out without parsing.
+struct ResourceDefinition {
+    std::wstring name;
+    double amount = 0.0;
+    double baseRate = 0.0;
+};
+
+struct Definitions {
+    std::array<ResourceDefinition, kResourceCount> resources;
+    std::vector<BuildingType> buildingTypes;
+};
+
+// Identifies one version of a source file; the cache is valid only for the
+// source it was compiled from
+struct DefinitionStamp {
+    uint64_t size = 0;
+    int64_t writeTime = 0;
+
+    bool operator==(const DefinitionStamp& other) const { return size == other.size && writeTime == other.writeTime; }
+    bool operator!=(const DefinitionStamp& other) const { return !(*this == other); }
+};
+
+inline bool GetDefinitionStamp(const std::string& path, DefinitionStamp& stamp) {
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(path, error);
+    if (error) return false;
+    auto writeTime = std::filesystem::last_write_time(path, error);
+    if (error) return false;
+
+    stamp.size = size;
+    stamp.writeTime = (int64_t)writeTime.time_since_epoch().count();
+    return true;
+}
+
+// Text is UTF-8; names may use any character in the Basic Multilingual Plane
+inline std::wstring WidenUtf8(const char* text, size_t length) {
+    std::wstring result;
+    result.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c < 0x80) {
+            result.push_back((wchar_t)c);
+        }
+        else if ((c & 0xe0) == 0xc0 && i + 1 < length) {
+            result.push_back((wchar_t)(((c & 0x1f) << 6) | (text[i + 1] & 0x3f)));
+            i += 1;
+        }
+        else if ((c & 0xf0) == 0xe0 && i + 2 < length) {
+            result.push_back((wchar_t)(((c & 0x0f) << 12) | ((text[i + 1] & 0x3f) << 6) | (text[i + 2] & 0x3f)));
+            i += 2;
+        }
+        else {
+            result.push_back(L'?');
+        }
+    }
+    return result;
+}
+
+inline std::string NarrowUtf8(const std::wstring& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (wchar_t wc : text) {
+        uint32_t c = (uint32_t)wc;
+        if (c < 0x80) {
+            result.push_back((char)c);
+        }
+        else if (c < 0x800) {
+            result.push_back((char)(0xc0 | (c >> 6)));
+            result.push_back((char)(0x80 | (c & 0x3f)));
+        }
+        else if (c < 0x10000) {
+            result.push_back((char)(0xe0 | (c >> 12)));
+            result.push_back((char)(0x80 | ((c >> 6) & 0x3f)));
+            result.push_back((char)(0x80 | (c & 0x3f)));
+        }
+        else {
+            result.push_back('?');
+        }
+    }
+    return result;
+}
+
+// Parse definition source text. On failure, error (if given) names the line.
+inline bool ParseDefinitions(const std::string& text, Definitions& definitions, std::string* error = nullptr) {
+    Definitions result;
+    int resourceCount = 0;
+    enum class Section { None, Resource, Building } section = Section::None;
+    int sectionLine = 0;
+
+    auto fail = [&](int line, const std::string& message) {
+        if (error) *error = "line " + std::to_string(line) + ": " + message;
+        return false;
+    };
+    auto trim = [](std::string value) {
+        size_t first = value.find_first_not_of(" \t\r");
+        if (first == std::string::npos) return std::string();
+        size_t last = value.find_last_not_of(" \t\r");
+        return value.substr(first, last - first + 1);
+    };
+    // A building that costs nothing could be bought without limit
+    auto finishBuilding = [&]() {
+        if (section != Section::Building) return true;
+        const BuildingType& type = result.buildingTypes.back();
+        for (int r = 0; r < kResourceCount; r++) {
+            if (type.cost[r] > 0.0) return true;
+        }
+        return fail(sectionLine, "building needs a positive cost");
+    };
+    auto findResource = [&](const std::string& name) {
+        std::wstring wideName = WidenUtf8(name.data(), name.size());
+        for (int r = 0; r < resourceCount; r++) {
+            if (result.resources[r].name == wideName) return r;
+        }
+        return -1;
+    };
+
+    size_t position = 0;
+    int lineNumber = 0;
+    while (position < text.size()) {
+        size_t end = text.find('\n', position);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(position, end - position);
+        position = end + 1;
+        lineNumber++;
+
+        line = trim(line);
+        bool isDescription = line.rfind("description", 0) == 0;
+        size_t comment = line.find_first_of("#;");
+        if (comment != std::string::npos && !(isDescription && comment > 0)) line = trim(line.substr(0, comment));
+        if (line.empty()) continue;
+
+        // Section header: [resource Name] or [building Name]
+        if (line.front() == '[') {
+            if (line.back() != ']') return fail(lineNumber, "unterminated section header");
+            std::string header = trim(line.substr(1, line.size() - 2));
+            size_t space = header.find_first_of(" \t");
+            std::string kind = header.substr(0, space);
+            std::string name = space == std::string::npos ? std::string() : trim(header.substr(space));
+            if (name.empty()) return fail(lineNumber, "section needs a name");
+            if (!finishBuilding()) return false;
+            sectionLine = lineNumber;
+
+            if (kind == "resource") {
+                if (resourceCount >= kResourceCount) return fail(lineNumber, "too many resources");
+                if (findResource(name) >= 0) return fail(lineNumber, "duplicate resource " + name);
+                result.resources[resourceCount++].name = WidenUtf8(name.data(), name.size());
+                section = Section::Resource;
+            }
+            else if (kind == "building") {
+                BuildingType type;
+                type.name = WidenUtf8(name.data(), name.size());
+
+                // Reload and saves match buildings by name
+                for (const auto& other : result.buildingTypes) {
+                    if (other.name == type.name) return fail(lineNumber, "duplicate building " + name);
+                }
+                result.buildingTypes.push_back(type);
+                section = Section::Building;
+            }
+            else {
+                return fail(lineNumber, "unknown section " + kind);
+            }
+            continue;
+        }
+
+        // key = value
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) return fail(lineNumber, "expected key = value");
+        std::string key = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+
+        // strtod also takes "inf" and "nan"; no key accepts them
+        auto number = [&](double& out) {
+            char* parseEnd = nullptr;
+            out = strtod(value.c_str(), &parseEnd);
+            return !value.empty() && parseEnd && *parseEnd == '\0' && std::isfinite(out);
+        };
+
+        double parsed = 0.0;
+        if (section == Section::Resource) {
+            ResourceDefinition& resource = result.resources[resourceCount - 1];
+            if (!number(parsed)) return fail(lineNumber, "expected a finite number");
+            if (key == "amount") {
+                if (parsed < 0.0) return fail(lineNumber, "amount must not be negative");
+                resource.amount = parsed;
+            }
+            else if (key == "rate") {
+                resource.baseRate = parsed;
+            }
+            else {
+                return fail(lineNumber, "unknown resource key " + key);
+            }
+        }
+        else if (section == Section::Building) {
+            BuildingType& type = result.buildingTypes.back();
+            if (key == "description") {
+                type.description = WidenUtf8(value.data(), value.size());
+                continue;
+            }
+            if (!number(parsed)) return fail(lineNumber, "expected a finite number");
+
+            // Rates must grow with building counts (the solver's bounds rely on it)
+            bool isModifier = key.rfind("bonus", 0) == 0 || key.rfind("multiplier", 0) == 0;
+            if (isModifier && !(parsed >= 0.0)) return fail(lineNumber, key + " must not be negative");
+
+            if (key == "count") {
+                if (!(parsed >= 0.0 && parsed <= std::numeric_limits<int>::max()) || parsed != std::floor(parsed)) {
+                    return fail(lineNumber, "count must be a whole number from 0 to " +
+                        std::to_string(std::numeric_limits<int>::max()));
+                }
+                type.baseCount = (int)parsed;
+            }
+            else if (key == "bonus") {
+                type.globalBonus = parsed;
+            }
+            else if (key == "multiplier") {
+                type.globalMultiplier = parsed;
+            }
+            else if (key == "growth") {
+                if (!(parsed >= 1.0)) return fail(lineNumber, "growth must be at least 1");
+                type.costGrowth = parsed;
+            }
+            else if (key.rfind("cost.", 0) == 0 || key.rfind("produces.", 0) == 0 || isModifier) {
+                size_t dot = key.find('.');
+                if (dot == std::string::npos) return fail(lineNumber, "unknown building key " + key);
+                std::string prefix = key.substr(0, dot);
+                std::string resourceName = key.substr(dot + 1);
+                int r = findResource(resourceName);
+                if (r < 0) return fail(lineNumber, "unknown resource " + resourceName);
+                if (!isModifier && !(parsed >= 0.0)) return fail(lineNumber, key + " must not be negative");
+
+                if (prefix == "cost") type.cost[r] = parsed;
+                else if (prefix == "produces") type.production[r] = parsed;
+                else if (prefix == "bonus") type.bonus[r] = parsed;
+                else if (prefix == "multiplier") type.multiplier[r] = parsed;
+                else return fail(lineNumber, "unknown building key " + key);
+            }
+            else {
+                return fail(lineNumber, "unknown building key " + key);
+            }
+        }
+        else {
+            return fail(lineNumber, "key outside of a section");
+        }
+    }
+
+    if (resourceCount != kResourceCount) {
+        return fail(lineNumber, "expected " + std::to_string(kResourceCount) + " resources");
+    }
+    if (!finishBuilding()) return false;
+    definitions = std::move(result);
+    return true;
+}
+
+// Compiled definitions
+//
+//   DefinitionsHeader                   fixed 48 bytes
+//   DefinitionsResource[resourceCount]  24 bytes each
+//   DefinitionsBuilding[buildingCount]  176 bytes each
+//   string pool                         UTF-8, padded to 8 bytes
+//
+// Same conventions as the save format: little-endian, naturally aligned,
+// used in place through a mapping, checksum over everything after the header.
+const uint32_t kDefinitionsMagic = 0x44434e49;     // "INCD"
+const uint32_t kDefinitionsVersion = 3;     // 2: production modifiers, 3: cost growth
+
+struct DefinitionsHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t resourceCount;
+    uint32_t buildingCount;
+    uint32_t stringPoolSize;
+    uint64_t sourceSize;
+    int64_t sourceWriteTime;
+    uint64_t checksum;
+};
+static_assert(sizeof(DefinitionsHeader) == 48, "DefinitionsHeader layout is part of the file format");
+
+struct DefinitionsString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct DefinitionsResource {
+    double amount;
+    double baseRate;
+    DefinitionsString name;
+};
+static_assert(sizeof(DefinitionsResource) == 24, "DefinitionsResource layout is part of the file format");
+
+struct DefinitionsBuilding {
+    double cost[kResourceCount];
+    double production[kResourceCount];
+    double bonus[kResourceCount];
+    double multiplier[kResourceCount];
+    double globalBonus;
+    double globalMultiplier;
+    double costGrowth;
+    DefinitionsString name;
+    DefinitionsString description;
+    int32_t baseCount;
+    uint32_t reserved;
+};
+static_assert(sizeof(DefinitionsBuilding) == 176, "DefinitionsBuilding layout is part of the file format");
+
+inline std::vector<unsigned char> CompileDefinitions(const Definitions& definitions, const DefinitionStamp& stamp) {
+    std::string pool;
+    auto addString = [&](const std::wstring& text) {
+        std::string utf8 = NarrowUtf8(text);
+        DefinitionsString entry = { (uint32_t)pool.size(), (uint32_t)utf8.size() };
+        pool += utf8;
+        return entry;
+    };
+
+    std::vector<DefinitionsResource> resources(kResourceCount);
+    for (int r = 0; r < kResourceCount; r++) {
+        resources[r].amount = definitions.resources[r].amount;
+        resources[r].baseRate = definitions.resources[r].baseRate;
+        resources[r].name = addString(definitions.resources[r].name);
+    }
+
+    std::vector<DefinitionsBuilding> buildings(definitions.buildingTypes.size());
+    for (size_t b = 0; b < buildings.size(); b++) {
+        const BuildingType& type = definitions.buildingTypes[b];
+        DefinitionsBuilding& record = buildings[b];
+        memset(&record, 0, sizeof(record));
+        for (int r = 0; r < kResourceCount; r++) {
+            record.cost[r] = type.cost[r];
+            record.production[r] = type.production[r];
+            record.bonus[r] = type.bonus[r];
+            record.multiplier[r] = type.multiplier[r];
+        }
+        record.globalBonus = type.globalBonus;
+        record.globalMultiplier = type.globalMultiplier;
+        record.costGrowth = type.costGrowth;
+        record.name = addString(type.name);
+        record.description = addString(type.description);
+        record.baseCount = type.baseCount;
+    }
+    pool.resize((pool.size() + 7) & ~(size_t)7, '\0');
+
+    size_t resourceBytes = resources.size() * sizeof(DefinitionsResource);
+    size_t buildingBytes = buildings.size() * sizeof(DefinitionsBuilding);
+    std::vector<unsigned char> buffer(sizeof(DefinitionsHeader) + resourceBytes + buildingBytes + pool.size());
+
+    unsigned char* body = buffer.data() + sizeof(DefinitionsHeader);
+    memcpy(body, resources.data(), resourceBytes);
+    if (buildingBytes) memcpy(body + resourceBytes, buildings.data(), buildingBytes);
+    if (!pool.empty()) memcpy(body + resourceBytes + buildingBytes, pool.data(), pool.size());
+
+    DefinitionsHeader header = {};
+    header.magic = kDefinitionsMagic;
+    header.version = kDefinitionsVersion;
+    header.headerSize = sizeof(DefinitionsHeader);
+    header.resourceCount = kResourceCount;
+    header.buildingCount = (uint32_t)buildings.size();
+    header.stringPoolSize = (uint32_t)pool.size();
+    header.sourceSize = stamp.size;
+    header.sourceWriteTime = stamp.writeTime;
+    header.checksum = SaveChecksum(body, buffer.size() - sizeof(DefinitionsHeader));
+    memcpy(buffer.data(), &header, sizeof(header));
+    return buffer;
+}
+
+// Load a compiled cache. Fails if it is damaged or was compiled from a
+// different version of the source.
+inline bool LoadCompiledDefinitions(const std::string& path, const DefinitionStamp& stamp, Definitions& definitions) {
+    MappedFile file;
+    if (!file.Open(path) || file.Size() < sizeof(DefinitionsHeader)) return false;
+
+    const auto* header = (const DefinitionsHeader*)file.Data();
+    if (header->magic != kDefinitionsMagic || header->version != kDefinitionsVersion) return false;
+    if (header->headerSize != sizeof(DefinitionsHeader) || header->resourceCount != kResourceCount) return false;
+    if (header->sourceSize != stamp.size || header->sourceWriteTime != stamp.writeTime) return false;
+
+    uint64_t resourceBytes = (uint64_t)header->resourceCount * sizeof(DefinitionsResource);
+    uint64_t buildingBytes = (uint64_t)header->buildingCount * sizeof(DefinitionsBuilding);
+    uint64_t bodySize = resourceBytes + buildingBytes + header->stringPoolSize;
+    if (header->stringPoolSize % 8 != 0 || file.Size() != sizeof(DefinitionsHeader) + bodySize) return false;
+
+    const unsigned char* body = file.Data() + sizeof(DefinitionsHeader);
+    if (SaveChecksum(body, bodySize) != header->checksum) return false;
+
+    const auto* resources = (const DefinitionsResource*)body;
+    const auto* buildings = (const DefinitionsBuilding*)(body + resourceBytes);
+    const char* pool = (const char*)(body + resourceBytes + buildingBytes);
+    bool stringsValid = true;
+    auto getString = [&](const DefinitionsString& entry) {
+        if ((uint64_t)entry.offset + entry.length > header->stringPoolSize) {
+            stringsValid = false;
+            return std::wstring();
+        }
+        return WidenUtf8(pool + entry.offset, entry.length);
+    };
+
+    Definitions result;
+    for (int r = 0; r < kResourceCount; r++) {
+        result.resources[r].name = getString(resources[r].name);
+        result.resources[r].amount = resources[r].amount;
+        result.resources[r].baseRate = resources[r].baseRate;
+    }
+
+    result.buildingTypes.resize(header->buildingCount);
+    for (uint32_t b = 0; b < header->buildingCount; b++) {
+        const DefinitionsBuilding& record = buildings[b];
+        BuildingType& type = result.buildingTypes[b];
+        for (int r = 0; r < kResourceCount; r++) {
+            type.cost[r] = record.cost[r];
+            type.production[r] = record.production[r];
+            type.bonus[r] = record.bonus[r];
+            type.multiplier[r] = record.multiplier[r];
+        }
+        type.globalBonus = record.globalBonus;
+        type.globalMultiplier = record.globalMultiplier;
+        type.costGrowth = record.costGrowth;
+        type.name = getString(record.name);
+        type.description = getString(record.description);
+        type.baseCount = record.baseCount;
+    }
+    if (!stringsValid) return false;
+
+    definitions = std::move(result);
+    return true;
+}
+
+inline bool ReadTextFile(const std::string& path, std::string& text) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    text.clear();
+    char chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) text.append(chunk, read);
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+// Load definitions through the cache: map the compiled file if it matches
+// the source, otherwise parse the source and rewrite the cache. A missing
+// or unwritable cache only costs the parse.
+inline bool LoadDefinitions(const std::string& sourcePath, const std::string& cachePath,
+    Definitions& definitions, std::string* error = nullptr) {
+    DefinitionStamp stamp;
+    if (!GetDefinitionStamp(sourcePath, stamp)) {
+        if (error) *error = "cannot read " + sourcePath;
+        return false;
+    }
+    if (LoadCompiledDefinitions(cachePath, stamp, definitions)) return true;
+
+    std::string text;
+    if (!ReadTextFile(sourcePath, text)) {
+        if (error) *error = "cannot read " + sourcePath;
+        return false;
+    }
+    if (!ParseDefinitions(text, definitions, error)) return false;
+
+    std::vector<unsigned char> compiled = CompileDefinitions(definitions, stamp);
+    WriteFileAtomic(cachePath, compiled.data(), compiled.size());
+    return true;
+}
+
+// Cache file used for a source when none is given: same name, .cache extension
+inline std::string DefaultCachePath(const std::string& sourcePath) {
+    return std::filesystem::path(sourcePath).replace_extension(".cache").string();
+}
+
+// The content of a game as definitions, e.g. the built-in content as a
+// starting point for generated variants. Amounts are the game's current ones.
+inline Definitions CaptureDefinitions(const GameState& game) {
+    Definitions definitions;
+    for (int r = 0; r < kResourceCount; r++) {
+        definitions.resources[r].name = game.resourceNames[r];
+        definitions.resources[r].amount = game.amounts[r].ToDouble();
+        definitions.resources[r].baseRate = game.baseRates[r];
+    }
+    definitions.buildingTypes = game.buildingTypes;
+    return definitions;
+}
+
+// Install definitions into a game. A new game takes the starting amounts
+// and counts; otherwise (hot reload) progress is kept and buildings are
+// matched by name, so reordering or adding types keeps what the player owns.
+inline void ApplyDefinitions(const Definitions& definitions, GameState& game, bool newGame) {
+    // What the player owns, by name, before the old types go away
+    std::vector<std::pair<std::wstring, int>> owned;
+    for (const auto& building : game.buildings) owned.emplace_back(building.type->name, building.count);
+
+    for (int r = 0; r < kResourceCount; r++) {
+        const ResourceDefinition& resource = definitions.resources[r];
+        game.resourceNames[r] = resource.name;
+        game.baseRates[r] = resource.baseRate;
+        if (newGame) game.amounts[r] = resource.amount;
+    }
+
+    game.buildingTypes = definitions.buildingTypes;
+    game.buildings.clear();
+    game.buildings.reserve(game.buildingTypes.size());
+    for (const auto& type : game.buildingTypes) {
+        int count = type.baseCount;
+        if (!newGame) {
+            for (const auto& entry : owned) {
+                if (entry.first == type.name) {
+                    count = entry.second;
+                    break;
+                }
+            }
+        }
+        game.buildings.push_back(Building(&type, count));
+    }
+
+    if (newGame) game.gameTime = 0.0f;
+    game.RebuildProduction();
+    game.MarkAllChanged();
+}
+
+// Watches a definition file and reloads it when it changes, so content can
+// be tuned while the game runs. Polls the file's size and write time a few
+// times a second; a file that fails to parse is ignored until it changes again.
+class DefinitionWatcher {
+public:
+    DefinitionWatcher(const std::string& sourcePath, const std::string& cachePath, float pollInterval = 0.5f)
+        : sourcePath(sourcePath), cachePath(cachePath), pollInterval(pollInterval) {
+        GetDefinitionStamp(sourcePath, stamp);
+    }
+
+    // Returns true when new definitions were loaded into `definitions`
+    bool Update(float deltaTime, Definitions& definitions) {
+        timer += deltaTime;
+        if (timer < pollInterval) return false;
+        timer = 0.0f;
+
+        DefinitionStamp current;
+        if (!GetDefinitionStamp(sourcePath, current) || current == stamp) return false;
+        stamp = current;
+
+        lastError.clear();
+        return LoadDefinitions(sourcePath, cachePath, definitions, &lastError);
+    }
+
+    const std::string& LastError() const { return lastError; }
+
+private:
+    std::string sourcePath;
+    std::string cachePath;
+    float pollInterval;
+    float timer = 0.0f;
+    DefinitionStamp stamp;
+    std::string lastError;
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include <windows.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+// GDI+ headers use min/max unqualified, and the build defines NOMINMAX so
+// windows.h does not break std::min/std::max in the game code
+namespace Gdiplus {
+    using std::min;
+    using std::max;
+}
+#include <gdiplus.h>
+#include "render.h"
+
+// RenderBackend for the Win32 window. Draws into a persistent back buffer
+// (memory DC and bitmap, recreated only on resize) with fonts, brushes,
+// pens and string formats created once and reused. Present() copies the
+// requested area of the back buffer to the window.
+//
+// GDI+ must be started before this is created and shut down only after it
+// is destroyed.
+class GdiplusRenderBackend : public RenderBackend {
+public:
+    GdiplusRenderBackend() : fontFamily(L"Arial") {
+        for (int i = 0; i < (int)RenderFont::Count; i++) {
+            const RenderFontInfo& info = GetFontInfo((RenderFont)i);
+            fonts[i] = std::make_unique<Gdiplus::Font>(&fontFamily, info.pixelSize,
+                info.bold ? Gdiplus::FontStyleBold : Gdiplus::FontStyleRegular, Gdiplus::UnitPixel);
+        }
+
+        topLeftFormat.SetFormatFlags(Gdiplus::StringFormatFlagsNoWrap);
+        centeredFormat.SetAlignment(Gdiplus::StringAlignmentCenter);
+        centeredFormat.SetLineAlignment(Gdiplus::StringAlignmentCenter);
+    }
+
+    ~GdiplusRenderBackend() override { ReleaseBackBuffer(); }
+
+    GdiplusRenderBackend(const GdiplusRenderBackend&) = delete;
+    GdiplusRenderBackend& operator=(const GdiplusRenderBackend&) = delete;
+
+    void Draw(const RenderList& list, const std::vector<RenderRect>& dirty, int width, int height) override {
+        if (!EnsureBackBuffer(width, height)) return;
+
+        // Clip to the dirty region and redraw only what overlaps it
+        Gdiplus::Region clip;
+        clip.MakeEmpty();
+        for (const auto& rect : dirty) clip.Union(Gdiplus::RectF(rect.x, rect.y, rect.width, rect.height));
+        graphics->SetClip(&clip, Gdiplus::CombineModeReplace);
+
+        for (const auto& command : list.commands) {
+            RenderRect bounds = command.Bounds();
+            bool visible = false;
+            for (const auto& rect : dirty) visible |= bounds.Intersects(rect);
+            if (visible) Execute(list, command);
+        }
+
+        graphics->ResetClip();
+    }
+
+    // Copy part of the back buffer to a window DC (from WM_PAINT)
+    void Present(HDC target, const RECT& area) const {
+        if (!memoryDC) return;
+        BitBlt(target, area.left, area.top, area.right - area.left, area.bottom - area.top,
+            memoryDC, area.left, area.top, SRCCOPY);
+    }
+
+private:
+    Gdiplus::FontFamily fontFamily;
+    std::unique_ptr<Gdiplus::Font> fonts[(int)RenderFont::Count];
+    Gdiplus::StringFormat topLeftFormat;
+    Gdiplus::StringFormat centeredFormat;
+    std::unordered_map<RenderColor, std::unique_ptr<Gdiplus::SolidBrush>> brushes;
+    std::unordered_map<uint64_t, std::unique_ptr<Gdiplus::Pen>> pens;
+
+    HDC memoryDC = NULL;
+    HBITMAP bitmap = NULL;
+    HBITMAP oldBitmap = NULL;
+    std::unique_ptr<Gdiplus::Graphics> graphics;
+    int bufferWidth = 0;
+    int bufferHeight = 0;
+
+    bool EnsureBackBuffer(int width, int height) {
+        if (memoryDC && width == bufferWidth && height == bufferHeight) return true;
+        ReleaseBackBuffer();
+        if (width <= 0 || height <= 0) return false;
+
+        HDC screen = GetDC(NULL);
+        memoryDC = CreateCompatibleDC(screen);
+        bitmap = CreateCompatibleBitmap(screen, width, height);
+        ReleaseDC(NULL, screen);
+        if (!memoryDC || !bitmap) {
+            ReleaseBackBuffer();
+            return false;
+        }
+
+        oldBitmap = (HBITMAP)SelectObject(memoryDC, bitmap);
+        graphics = std::make_unique<Gdiplus::Graphics>(memoryDC);
+        graphics->SetSmoothingMode(Gdiplus::SmoothingModeAntiAlias);
+        graphics->SetTextRenderingHint(Gdiplus::TextRenderingHintAntiAlias);
+        bufferWidth = width;
+        bufferHeight = height;
+        return true;
+    }
+
+    void ReleaseBackBuffer() {
+        graphics.reset();
+        if (memoryDC && oldBitmap) SelectObject(memoryDC, oldBitmap);
+        if (bitmap) DeleteObject(bitmap);
+        if (memoryDC) DeleteDC(memoryDC);
+        memoryDC = NULL;
+        bitmap = NULL;
+        oldBitmap = NULL;
+        bufferWidth = 0;
+        bufferHeight = 0;
+    }
+
+    Gdiplus::SolidBrush* Brush(RenderColor color) {
+        auto& brush = brushes[color];
+        if (!brush) brush = std::make_unique<Gdiplus::SolidBrush>(Gdiplus::Color(color));
+        return brush.get();
+    }
+
+    Gdiplus::Pen* Pen(RenderColor color, float width) {
+        uint32_t widthBits;
+        memcpy(&widthBits, &width, sizeof(widthBits));
+        auto& pen = pens[((uint64_t)color << 32) | widthBits];
+        if (!pen) pen = std::make_unique<Gdiplus::Pen>(Gdiplus::Color(color), width);
+        return pen.get();
+    }
+
+    void Execute(const RenderList& list, const RenderCommand& command) {
+        const RenderRect& r = command.rect;
+        switch (command.type) {
+        case RenderCommandType::FillRect:
+            graphics->FillRectangle(Brush(command.color), r.x, r.y, r.width, r.height);
+            break;
+        case RenderCommandType::StrokeRect:
+            graphics->DrawRectangle(Pen(command.color, command.penWidth), r.x, r.y, r.width, r.height);
+            break;
+        case RenderCommandType::Text: {
+            Gdiplus::RectF layout(r.x, r.y, r.width, r.height);
+            const Gdiplus::StringFormat* format = command.align == TextAlign::Center ? &centeredFormat : &topLeftFormat;
+            graphics->DrawString(list.TextOf(command), (INT)command.textLength, fonts[(int)command.font].get(),
+                layout, format, Brush(command.color));
+            break;
+        }
+        }
+    }
+};
@@ -0,0 +1,216 @@
+// Headless simulation driver. Builds GameState without windows.h and runs
+// scripted sessions from the command line, e.g.
+//
+//   incremental_headless --hours 8 --buy-every 30
+//   incremental_headless --hours 1000 --buy-every 60 --buy-max --fast
+//   incremental_headless --hours 8 --buy-every 30 --record session.cmdlog
+//   incremental_headless --replay session.cmdlog
+//
+// Options:
+//   --hours H        Simulated session length (default 1)
+//   --dt SECONDS     Frame delta for per-frame stepping (default 1/60)
+//   --buy-every X    Every X simulated seconds, buy one of each affordable building
+//   --buy-max        With --buy-every, buy as many of each as possible instead
+//   --fast           Jump between purchase points with GameState::Advance
+//                    instead of stepping Update() frame by frame
+//   --report H       Print a progress line every H simulated hours (default 1)
+//   --defs FILE      Load content from a definition file instead of the built-in set
+//   --record FILE    Write the session to a command log
+//   --replay FILE    Re-run a command log instead of a scripted session
+//   --exact          With --replay, apply every tick as recorded instead of
+//                    collapsing idle intervals. Bit-exact only for logs
+//                    recorded frame by frame; merged tick records are still
+//                    integrated in closed form
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "game.h"
+#include "commandlog.h"
+#include "definitions.h"
+
+struct SessionOptions {
+    double hours = 1.0;
+    double deltaTime = 1.0 / 60.0;
+    double buyEvery = 0.0;
+    bool buyMax = false;
+    bool fast = false;
+    double reportHours = 1.0;
+    std::string definitionsPath;
+    std::string recordPath;
+    std::string replayPath;
+    bool exact = false;
+};
+
+static void PrintUsage() {
+    printf("usage: incremental_headless [--hours H] [--dt SECONDS] [--buy-every X] [--buy-max] [--fast] [--report H] [--defs FILE] [--record FILE]\n");
+    printf("       incremental_headless --replay FILE [--exact] [--defs FILE]\n");
+}
+
+static bool ParseOptions(int argc, char** argv, SessionOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--hours") == 0 && hasValue) options.hours = atof(argv[++i]);
+        else if (strcmp(arg, "--dt") == 0 && hasValue) options.deltaTime = atof(argv[++i]);
+        else if (strcmp(arg, "--buy-every") == 0 && hasValue) options.buyEvery = atof(argv[++i]);
+        else if (strcmp(arg, "--report") == 0 && hasValue) options.reportHours = atof(argv[++i]);
+        else if (strcmp(arg, "--defs") == 0 && hasValue) options.definitionsPath = argv[++i];
+        else if (strcmp(arg, "--record") == 0 && hasValue) options.recordPath = argv[++i];
+        else if (strcmp(arg, "--replay") == 0 && hasValue) options.replayPath = argv[++i];
+        else if (strcmp(arg, "--exact") == 0) options.exact = true;
+        else if (strcmp(arg, "--buy-max") == 0) options.buyMax = true;
+        else if (strcmp(arg, "--fast") == 0) options.fast = true;
+        else return false;
+    }
+    return options.hours > 0.0 && options.deltaTime > 0.0 && options.reportHours > 0.0;
+}
+
+// Resource and building names are plain ASCII
+static std::string Narrow(const std::wstring& text) {
+    return std::string(text.begin(), text.end());
+}
+
+static void PrintHeader(const GameState& game) {
+    printf("%10s", "hours");
+    for (int r = 0; r < kResourceCount; r++) printf(" %14s", Narrow(game.resourceNames[r]).c_str());
+    for (const auto& building : game.buildings) printf(" %12s", Narrow(building.type->name).c_str());
+    printf("\n");
+}
+
+static void PrintProgress(const GameState& game, double seconds) {
+    printf("%10.2f", seconds / 3600.0);
+    for (int r = 0; r < kResourceCount; r++) {
+        const BigNumber& amount = game.amounts[r];
+        if (amount.exponent == 0) printf(" %14.1f", amount.mantissa);
+        else printf(" %14.3e", amount.ToDouble());
+    }
+    for (const auto& building : game.buildings) printf(" %12d", building.count);
+    printf("\n");
+}
+
+// Everything goes through commands so a session can be recorded
+static bool Execute(GameState& game, CommandLog* log, const Command& command) {
+    if (log) return log->Execute(game, command);
+    return ApplyCommand(game, command);
+}
+
+static int PurchaseRound(GameState& game, CommandLog* log, bool buyMax) {
+    int purchased = 0;
+    for (int i = 0; i < (int)game.buildings.size(); i++) {
+        int n = buyMax ? game.MaxAffordable(i) : (game.CanAfford(i) ? 1 : 0);
+        if (n > 0 && Execute(game, log, Command::Purchase(i, n))) purchased += n;
+    }
+    return purchased;
+}
+
+// Built-in content unless a definition file was given
+static bool CreateGame(const SessionOptions& options, GameState& game) {
+    if (options.definitionsPath.empty()) return true;
+
+    Definitions definitions;
+    std::string error;
+    if (!LoadDefinitions(options.definitionsPath, DefaultCachePath(options.definitionsPath), definitions, &error)) {
+        fprintf(stderr, "%s: %s\n", options.definitionsPath.c_str(), error.c_str());
+        return false;
+    }
+    ApplyDefinitions(definitions, game, true);
+    return true;
+}
+
+static int RunReplay(const SessionOptions& options) {
+    CommandLog log;
+    if (!log.Load(options.replayPath)) {
+        fprintf(stderr, "cannot read command log %s\n", options.replayPath.c_str());
+        return 1;
+    }
+
+    GameState game;
+    if (!CreateGame(options, game)) return 1;
+    ReplayMode mode = options.exact ? ReplayMode::Exact : ReplayMode::Collapsed;
+    ReplayResult result = CommandReplay::Run(log, game, mode);
+
+    PrintHeader(game);
+    PrintProgress(game, result.simulatedSeconds);
+    printf("\nreplayed %lld commands (%lld frames) in %lld steps, %.3f s wall (%.0fx real time)\n",
+        (long long)result.commandsApplied, (long long)result.framesReplayed, (long long)result.tickSteps,
+        result.wallSeconds, result.SpeedupOverRealTime());
+    printf("%lld resyncs, %lld divergences\n", (long long)result.resyncs, (long long)result.divergences);
+    return result.divergences == 0 ? 0 : 2;
+}
+
+int main(int argc, char** argv) {
+    SessionOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    if (!options.replayPath.empty()) return RunReplay(options);
+
+    GameState game;
+    if (!CreateGame(options, game)) return 1;
+    PrintHeader(game);
+    PrintProgress(game, 0.0);
+
+    CommandLog recording;
+    CommandLog* log = options.recordPath.empty() ? nullptr : &recording;
+    if (log) log->Begin(game);
+
+    const double sessionSeconds = options.hours * 3600.0;
+    const double reportSeconds = options.reportHours * 3600.0;
+    double elapsed = 0.0;
+    double nextPurchase = options.buyEvery;
+    double nextReport = reportSeconds;
+    int64_t frames = 0;
+    int64_t purchases = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (elapsed < sessionSeconds) {
+        // Next scripted event: a purchase round, a report, or the session end
+        double nextEvent = std::min(sessionSeconds, nextReport);
+        if (options.buyEvery > 0.0) nextEvent = std::min(nextEvent, nextPurchase);
+
+        if (options.fast) {
+            Execute(game, log, Command::Advance(nextEvent - elapsed));
+            elapsed = nextEvent;
+        }
+        else {
+            // Step whole frames up to the event, like the windowed main loop
+            while (elapsed < nextEvent) {
+                float deltaTime = (float)std::min(options.deltaTime, nextEvent - elapsed);
+                Execute(game, log, Command::Tick(deltaTime));
+                elapsed += deltaTime;
+                frames++;
+            }
+        }
+
+        if (options.buyEvery > 0.0 && elapsed >= nextPurchase) {
+            purchases += PurchaseRound(game, log, options.buyMax);
+            nextPurchase += options.buyEvery;
+        }
+
+        if (elapsed >= nextReport) {
+            PrintProgress(game, elapsed);
+            nextReport += reportSeconds;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double wallSeconds = std::chrono::duration<double>(end - start).count();
+
+    printf("\nsimulated %.2f hours in %.3f s wall (%.0fx real time), %lld frames, %lld purchases\n",
+        elapsed / 3600.0, wallSeconds, elapsed / std::max(wallSeconds, 1e-9),
+        (long long)frames, (long long)purchases);
+
+    if (log) {
+        if (!log->Save(options.recordPath)) {
+            fprintf(stderr, "cannot write command log %s\n", options.recordPath.c_str());
+            return 1;
+        }
+        printf("recorded %zu commands to %s\n", log->commands.size(), options.recordPath.c_str());
+    }
+    return 0;
+}
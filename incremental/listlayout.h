@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include "render.h"
+
+// Layout of a long list of equal-sized cells in a scrollable viewport, e.g.
+// one button per building type.
+//
+// Cells fill rows left to right inside the viewport; the list scrolls by
+// whole rows, so every visible cell is fully inside it and nothing needs
+// clipping. Because the cells form a uniform grid, everything is arithmetic
+// on the row and column pitch: the visible range, a cell's rectangle, and
+// hit-testing a point are O(1) however many items there are. Callers only
+// create, update and draw the cells in VisibleBegin()..VisibleEnd().
+class ListLayout {
+public:
+    RenderRect viewport;            // Screen area the cells live in
+    float cellWidth = 0.0f;
+    float cellHeight = 0.0f;
+    float spacingX = 0.0f;          // Gaps between cells, not hit-testable
+    float spacingY = 0.0f;
+
+    ListLayout() = default;
+    ListLayout(const RenderRect& viewport, float cellWidth, float cellHeight, float spacingX, float spacingY)
+        : viewport(viewport), cellWidth(cellWidth), cellHeight(cellHeight), spacingX(spacingX), spacingY(spacingY) {
+    }
+
+    float PitchX() const { return cellWidth + spacingX; }
+    float PitchY() const { return cellHeight + spacingY; }
+
+    // At least one, so an undersized viewport still shows something
+    int Columns() const { return std::max(1, (int)((viewport.width + spacingX) / PitchX())); }
+    int VisibleRows() const { return std::max(1, (int)((viewport.height + spacingY) / PitchY())); }
+
+    int ItemCount() const { return itemCount; }
+    int TotalRows() const { return (itemCount + Columns() - 1) / Columns(); }
+    int FirstRow() const { return firstRow; }
+    int MaxFirstRow() const { return std::max(0, TotalRows() - VisibleRows()); }
+    bool CanScroll() const { return MaxFirstRow() > 0; }
+
+    void SetItemCount(int count) {
+        itemCount = std::max(0, count);
+        firstRow = std::min(firstRow, MaxFirstRow());
+    }
+
+    // Scroll by whole rows (positive is down). Returns true if the visible
+    // range moved.
+    bool ScrollRows(int rows) {
+        return ScrollToRow(firstRow + rows);
+    }
+
+    bool ScrollToRow(int row) {
+        int clamped = std::clamp(row, 0, MaxFirstRow());
+        if (clamped == firstRow) return false;
+        firstRow = clamped;
+        return true;
+    }
+
+    // Bring an item into view with as little scrolling as possible
+    void ScrollIntoView(int item) {
+        int row = item / Columns();
+        if (row < firstRow) ScrollToRow(row);
+        else if (row >= firstRow + VisibleRows()) ScrollToRow(row - VisibleRows() + 1);
+    }
+
+    // Visible items are [VisibleBegin(), VisibleEnd())
+    int VisibleBegin() const { return std::min(itemCount, firstRow * Columns()); }
+    int VisibleEnd() const { return std::min(itemCount, (firstRow + VisibleRows()) * Columns()); }
+    bool IsVisible(int item) const { return item >= VisibleBegin() && item < VisibleEnd(); }
+
+    // Screen rectangle of a visible item
+    RenderRect ItemRect(int item) const {
+        int columns = Columns();
+        int row = item / columns - firstRow;
+        int column = item % columns;
+        return RenderRect{ viewport.x + column * PitchX(), viewport.y + row * PitchY(), cellWidth, cellHeight };
+    }
+
+    // The visible item whose cell contains the point, or -1 (outside the
+    // viewport, in a gap between cells, or past the last item)
+    int HitTest(float x, float y) const {
+        float localX = x - viewport.x;
+        float localY = y - viewport.y;
+        if (localX < 0.0f || localY < 0.0f || localX > viewport.width || localY > viewport.height) return -1;
+
+        int column = (int)(localX / PitchX());
+        int row = (int)(localY / PitchY());
+        if (column >= Columns() || row >= VisibleRows()) return -1;
+
+        // Cell edges are inclusive, like Button::Contains
+        if (localX - column * PitchX() > cellWidth || localY - row * PitchY() > cellHeight) return -1;
+
+        int item = (firstRow + row) * Columns() + column;
+        return item < itemCount ? item : -1;
+    }
+
+    // Scroll bar thumb along the right edge of the viewport; empty when
+    // everything fits
+    RenderRect ScrollThumb(float width) const {
+        if (!CanScroll()) return RenderRect{};
+        float trackHeight = viewport.height;
+        float thumbHeight = std::max(width * 2.0f, trackHeight * VisibleRows() / TotalRows());
+        float thumbY = viewport.y + (trackHeight - thumbHeight) * firstRow / MaxFirstRow();
+        return RenderRect{ viewport.Right() + 4.0f, thumbY, width, thumbHeight };
+    }
+
+    RenderRect ScrollTrack(float width) const {
+        if (!CanScroll()) return RenderRect{};
+        return RenderRect{ viewport.Right() + 4.0f, viewport.y, width, viewport.height };
+    }
+
+private:
+    int itemCount = 0;
+    int firstRow = 0;
+};
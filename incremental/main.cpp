@@ -1,15 +1,50 @@
 #include <windows.h>
-#include <gdiplus.h>
+#include "alloccount.h"
 #include "game.h"
+#include "commandlog.h"
+#include "definitions.h"
+#include "profiler.h"
+#include "savegame.h"
+#include "simulation.h"
+#include "snapshots.h"
 #include "ui.h"
+#include "gdiplus_backend.h"
 
 #pragma comment(lib, "gdiplus.lib")
 
+// Debug builds count allocations, so the simulation thread can report
+// ticks that touched the heap
+INCREMENTAL_DEFINE_ALLOCATION_HOOK()
+
 using namespace Gdiplus;
 
-// Global state
+// Global state. While the simulation thread runs it owns g_game; the UI
+// reads and draws g_view, the latest snapshot.
 GameState g_game;
+GameState* g_view = &g_game;
 UIManager g_ui;
+const double kSimulationHz = 60.0;
+
+// Rendering: the UI records a frame, the renderer redraws what changed into
+// the backend's back buffer, and WM_PAINT copies it to the window
+RenderList g_renderList;
+Renderer g_renderer;
+std::unique_ptr<GdiplusRenderBackend> g_backend;
+
+// Persistence
+const char* kSavePath = "incremental.sav";
+const char* kCommandLogPath = "session.cmdlog";     // Last session, for bug reports
+const char* kSyncDirectory = "sync";                // Snapshot history, stands in for cloud storage
+const char* kAutomationPath = "automation.txt";     // Auto-buy rules, one per line (automation.h)
+const float kAutosaveInterval = 10.0f;
+
+// F3 toggles profiling and the frame-time overlay, F4 writes a Chrome trace
+const char* kProfilePath = "profile.json";
+
+// Content, hot-reloaded while the game runs
+const char* kDefinitionsPath = "definitions.ini";
+const char* kDefinitionsCachePath = "definitions.cache";
+CommandLog g_commandLog;
 
 // Timing
 LARGE_INTEGER g_frequency;
@@ -56,6 +91,14 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         if (wParam == VK_ESCAPE) {
             PostQuitMessage(0);
         }
+        else if (wParam == VK_F3) {
+            g_ui.showProfiler = !g_ui.showProfiler;
+            Profiler::SetEnabled(g_ui.showProfiler);
+        }
+        else if (wParam == VK_F4) {
+            g_ui.clickFeedback = Profiler::Instance().WriteChromeTrace(kProfilePath) ? L"Trace saved to profile.json" : L"Could not save trace";
+            g_ui.feedbackTimer = 2.0f;
+        }
         return 0;
 
     case WM_MOUSEMOVE: {
@@ -68,7 +111,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     case WM_LBUTTONDOWN: {
         int x = LOWORD(lParam);
         int y = HIWORD(lParam);
-        g_ui.HandleMouseDown(x, y, g_game);
+        g_ui.HandleMouseDown(x, y, *g_view);
         return 0;
     }
 
@@ -77,31 +120,26 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         return 0;
     }
 
+    case WM_MOUSEWHEEL: {
+        // Wheel positions are in screen coordinates
+        POINT point = { (short)LOWORD(lParam), (short)HIWORD(lParam) };
+        ScreenToClient(hwnd, &point);
+        g_ui.HandleMouseWheel(point.x, point.y, GET_WHEEL_DELTA_WPARAM(wParam));
+        return 0;
+    }
+
     case WM_PAINT: {
+        // The back buffer is already up to date; just copy the exposed area
+        PROFILE_ZONE("WM_PAINT blit");
         PAINTSTRUCT ps;
         HDC hdc = BeginPaint(hwnd, &ps);
-
-        // Double buffering
-        RECT rect;
-        GetClientRect(hwnd, &rect);
-        int width = rect.right - rect.left;
-        int height = rect.bottom - rect.top;
-
-        HDC hdcMem = CreateCompatibleDC(hdc);
-        HBITMAP hbmMem = CreateCompatibleBitmap(hdc, width, height);
-        HBITMAP hbmOld = (HBITMAP)SelectObject(hdcMem, hbmMem);
-
-        g_ui.Render(hdcMem, width, height, g_game, g_fps);
-
-        BitBlt(hdc, 0, 0, width, height, hdcMem, 0, 0, SRCCOPY);
-
-        SelectObject(hdcMem, hbmOld);
-        DeleteObject(hbmMem);
-        DeleteDC(hdcMem);
-
+        if (g_backend) g_backend->Present(hdc, ps.rcPaint);
         EndPaint(hwnd, &ps);
         return 0;
     }
+
+    case WM_ERASEBKGND:
+        return 1;
     }
 
     return DefWindowProc(hwnd, uMsg, wParam, lParam);
@@ -144,9 +182,39 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
     ShowWindow(hwnd, nCmdShow);
 
-    // Initialize game and UI
+    // Initialize game and UI. Without a definition file the built-in
+    // content is used.
+    Definitions definitions;
+    if (LoadDefinitions(kDefinitionsPath, kDefinitionsCachePath, definitions)) {
+        ApplyDefinitions(definitions, g_game, true);
+    }
+    DefinitionWatcher definitionWatcher(kDefinitionsPath, kDefinitionsCachePath);
+
+    // Without a local save, fall back to the newest synced snapshot
+    SnapshotStore snapshots(kSyncDirectory);
+    snapshots.Open();
+    SaveData synced;
+    if (!LoadGame(kSavePath, g_game) && snapshots.RestoreLatest(synced)) ApplySaveData(synced, g_game);
+    AutosaveWorker autosave(kSavePath, [&snapshots](const SaveData& save) { snapshots.Write(save); });
+    float autosaveTimer = 0.0f;
+    g_commandLog.Begin(g_game);
+
+    // Auto-buy rules run on the simulation thread, after every tick
+    AutomationEngine automation;
+    std::vector<AutomationRule> rules;
+    if (LoadAutomationRules(kAutomationPath, g_game, rules)) automation.SetRules(rules);
+
+    // The game runs at a fixed rate on its own thread, which records
+    // every tick and player command into the log
+    SimulationThread simulation(g_game, kSimulationHz, &g_commandLog);
+    simulation.SetAutomation(&automation);
+    g_ui.simulation = &simulation;
+    simulation.Start();
+
     InitTiming();
+    Profiler::SetThreadName("Main");
     g_ui.Initialize();
+    g_backend = std::make_unique<GdiplusRenderBackend>();
 
     // Main game loop
     MSG msg = {};
@@ -163,20 +231,63 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         }
 
         if (running) {
-            // Update game
+            // Pick up the newest simulated state; the frame never waits for a tick
             float deltaTime = GetDeltaTime();
-            g_game.Update(deltaTime);
-            g_ui.Update(deltaTime, g_game);
+            g_ui.frameTimes.Add(deltaTime);
+            SimulationSnapshot& snapshot = simulation.AcquireSnapshot();
+            g_view = &snapshot.game;
+            g_ui.Update(deltaTime, snapshot.game);
+            g_ui.model.UpdateSimulation(snapshot.stats.measuredHz, snapshot.stats.averageWakeLateMicros / 1000.0);
+
+            // The command log only replays against the content it was
+            // recorded with, so a reload starts a new one
+            if (definitionWatcher.Update(deltaTime, definitions)) {
+                simulation.Invoke([definitions, &automation](GameState& game) {
+                    ApplyDefinitions(definitions, game, false);
+                    g_commandLog.Begin(game);
+
+                    // Rules name buildings; compile them against the new content
+                    std::vector<AutomationRule> reloaded;
+                    if (LoadAutomationRules(kAutomationPath, game, reloaded)) automation.SetRules(reloaded);
+                });
+            }
+
+            // Autosave is written on a background thread from the snapshot
+            autosaveTimer += deltaTime;
+            if (autosaveTimer >= kAutosaveInterval) {
+                autosave.RequestSave(snapshot.game);
+                autosaveTimer = 0.0f;
+            }
 
-            // Render
-            InvalidateRect(hwnd, NULL, FALSE);
+            // Render, then invalidate only what changed
+            RECT client;
+            GetClientRect(hwnd, &client);
+            g_ui.Record(g_renderList, client.right - client.left, client.bottom - client.top, g_fps);
+            {
+                PROFILE_ZONE("Renderer::Submit");
+                for (const RenderRect& dirty : g_renderer.Submit(g_renderList, client.right - client.left, client.bottom - client.top, *g_backend)) {
+                    RECT area = { (LONG)floor(dirty.x), (LONG)floor(dirty.y), (LONG)ceil(dirty.Right()), (LONG)ceil(dirty.Bottom()) };
+                    InvalidateRect(hwnd, &area, FALSE);
+                }
+            }
+            PROFILE_COUNTER("Render commands changed", g_renderer.commandsChanged);
+            PROFILE_COUNTER("Sim ticks", snapshot.stats.ticks);
 
             // Sleep to limit frame rate to ~60 FPS
             Sleep(1);
         }
     }
 
-    // Cleanup
+    // Final save before exit, once the game is ours again
+    simulation.Stop();
+    g_view = &g_game;
+    g_ui.simulation = nullptr;
+    autosave.RequestSave(g_game);
+    autosave.Flush();
+    g_commandLog.Save(kCommandLogPath);
+
+    // Cleanup (GDI+ objects must go before GDI+ itself)
+    g_backend.reset();
     GdiplusShutdown(gdiplusToken);
 
     return 0;
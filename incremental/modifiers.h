@@ -0,0 +1,157 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Production rates as a dependency graph of modifiers.
+//
+// For each resource r:
+//
+//   flat[r]       = baseRate[r] + sum of production[r] * count
+//   bonus[r]      = sum of (bonus[r] + globalBonus) * count          additive, +0.1 = +10%
+//   multiplier[r] = product of ((1 + multiplier[r]) * (1 + globalMultiplier))^count
+//   rate[r]       = flat[r] * (1 + bonus[r]) * multiplier[r]
+//
+// Global bonuses and multipliers have their own nodes feeding every
+// resource. Each node keeps its contributing buildings in a segment tree, so
+// a change of one building's count re-evaluates only the nodes that building
+// feeds, in O(log contributors) each, and then only the rates those nodes
+// feed. Every internal value is recombined from its children, so the result
+// depends only on the counts, never on the order of updates: two games with
+// the same content and counts have bit-identical rates.
+//
+// Build() is templated on the building type list so this does not depend on
+// game.h; a type needs production, bonus and multiplier tables plus
+// globalBonus and globalMultiplier.
+template <int ResourceCount>
+class ModifierGraph {
+public:
+    // Nodes re-evaluated since construction (tree levels recombined)
+    int64_t evaluations = 0;
+
+    template <typename BuildingTypeList>
+    void Build(const double (&baseRates)[ResourceCount], const BuildingTypeList& types) {
+        for (int r = 0; r < ResourceCount; r++) base[r] = baseRates[r];
+        for (auto& node : nodes) node = Node();
+        nodes[kGlobalMultiplier].product = true;
+        for (int r = 0; r < ResourceCount; r++) nodes[MultiplierNode(r)].product = true;
+
+        // Which nodes each building feeds, and with what coefficient
+        int buildingCount = (int)types.size();
+        feeds.assign(buildingCount, {});
+        counts.assign(buildingCount, 0);
+        for (int b = 0; b < buildingCount; b++) {
+            const auto& type = types[b];
+            for (int r = 0; r < ResourceCount; r++) {
+                AddFeed(b, FlatNode(r), type.production[r]);
+                AddFeed(b, BonusNode(r), type.bonus[r]);
+                AddFeed(b, MultiplierNode(r), type.multiplier[r]);
+            }
+            AddFeed(b, kGlobalBonus, type.globalBonus);
+            AddFeed(b, kGlobalMultiplier, type.globalMultiplier);
+        }
+
+        for (auto& node : nodes) node.Allocate();
+        for (int r = 0; r < ResourceCount; r++) EvaluateRate(r);
+    }
+
+    int BuildingCount() const { return (int)counts.size(); }
+    int Count(int building) const { return counts[building]; }
+    const double* Rates() const { return rates; }
+
+    // The three factors of rate[r]
+    double Flat(int r) const { return base[r] + nodes[FlatNode(r)].Root(); }
+    double Bonus(int r) const { return nodes[BonusNode(r)].Root() + nodes[kGlobalBonus].Root(); }
+    double Multiplier(int r) const { return nodes[MultiplierNode(r)].Root() * nodes[kGlobalMultiplier].Root(); }
+
+    // Returns a bit mask of the resources whose rate was re-evaluated
+    uint32_t SetCount(int building, int count) {
+        if (counts[building] == count) return 0;
+        counts[building] = count;
+
+        uint32_t dirty = 0;
+        for (const Feed& feed : feeds[building]) {
+            evaluations += nodes[feed.node].Set(feed.leaf, count);
+            dirty |= NodeResources(feed.node);
+        }
+        for (int r = 0; r < ResourceCount; r++) {
+            if (dirty & (1u << r)) EvaluateRate(r);
+        }
+        return dirty;
+    }
+
+    // Bring every count in line (only changed buildings do any work)
+    template <typename CountList>
+    uint32_t SetCounts(const CountList& newCounts) {
+        uint32_t dirty = 0;
+        for (int b = 0; b < (int)counts.size(); b++) dirty |= SetCount(b, newCounts[b]);
+        return dirty;
+    }
+
+private:
+    static constexpr int kGlobalBonus = 3 * ResourceCount;
+    static constexpr int kGlobalMultiplier = 3 * ResourceCount + 1;
+    static constexpr int kNodeCount = 3 * ResourceCount + 2;
+
+    static int FlatNode(int r) { return r; }
+    static int BonusNode(int r) { return ResourceCount + r; }
+    static int MultiplierNode(int r) { return 2 * ResourceCount + r; }
+
+    static uint32_t NodeResources(int node) {
+        if (node >= kGlobalBonus) return (1u << ResourceCount) - 1;
+        return 1u << (node % ResourceCount);
+    }
+
+    // One modifier: a sum of coefficient * count, or a product of
+    // (1 + coefficient)^count, over the buildings that feed it
+    struct Node {
+        bool product = false;
+        std::vector<double> coefficients;   // Per leaf
+        std::vector<double> tree;           // Implicit binary tree, root at 1, leaves from `leaves`
+        int leaves = 0;
+
+        double Identity() const { return product ? 1.0 : 0.0; }
+        double Root() const { return leaves > 0 ? tree[1] : Identity(); }
+
+        void Allocate() {
+            leaves = 1;
+            while (leaves < (int)coefficients.size()) leaves *= 2;
+            tree.assign(2 * leaves, Identity());
+        }
+
+        // Returns the number of values recombined
+        int Set(int leaf, int count) {
+            double coefficient = coefficients[leaf];
+            int i = leaves + leaf;
+            tree[i] = product ? std::pow(1.0 + coefficient, count) : coefficient * count;
+            int evaluated = 1;
+            for (i /= 2; i >= 1; i /= 2) {
+                tree[i] = product ? tree[2 * i] * tree[2 * i + 1] : tree[2 * i] + tree[2 * i + 1];
+                evaluated++;
+            }
+            return evaluated;
+        }
+    };
+
+    struct Feed {
+        int node;
+        int leaf;
+    };
+
+    Node nodes[kNodeCount];
+    std::vector<std::vector<Feed>> feeds;   // Per building
+    std::vector<int> counts;
+    double base[ResourceCount] = {};
+    double rates[ResourceCount] = {};
+
+    void AddFeed(int building, int node, double coefficient) {
+        if (coefficient == 0.0) return;
+        feeds[building].push_back(Feed{ node, (int)nodes[node].coefficients.size() });
+        nodes[node].coefficients.push_back(coefficient);
+    }
+
+    void EvaluateRate(int r) {
+        rates[r] = Flat(r) * (1.0 + Bonus(r)) * Multiplier(r);
+        evaluations++;
+    }
+};
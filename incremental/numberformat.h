@@ -0,0 +1,173 @@
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "bignumber.h"
+
+// Number formatting for display text, without streams, locales or heap
+// allocation.
+//
+// Digits come from std::to_chars (correctly rounded, always '.' as the
+// decimal point) into a fixed buffer on the stack. Two notations:
+//
+//   Full      fixed with the requested decimals, e.g. 1234567.8; values of
+//             1e15 and above switch to scientific, 1.23e120
+//   Compact   below 1000 as Full; then three significant digits and a
+//             suffix up to Dc (1e33), e.g. 1.23K, 4.5M; then 1e120
+//
+// Full matches what a stream with std::fixed and std::setprecision printed
+// for the same values (and BigNumber's operator<< for huge ones), so it can
+// replace one without changing the text.
+enum class NumberNotation {
+    Full,
+    Compact,
+};
+
+// Formatted characters, ASCII only
+struct NumberText {
+    static constexpr int kCapacity = 48;
+
+    char chars[kCapacity];
+    int length = 0;
+
+    std::string_view View() const { return std::string_view(chars, length); }
+};
+
+namespace numberformat_detail {
+
+// Thousands suffixes for Compact, index = power of 1000
+constexpr const char* kSuffixes[] = { "", "K", "M", "B", "T", "Qa", "Qi", "Sx", "Sp", "Oc", "No", "Dc" };
+constexpr int kSuffixCount = sizeof(kSuffixes) / sizeof(kSuffixes[0]);
+
+// Full switches to scientific here; fixed digits stop being meaningful
+constexpr double kFullLimit = 1e15;
+
+inline void Append(NumberText& text, const char* s) {
+    while (*s && text.length < NumberText::kCapacity) text.chars[text.length++] = *s++;
+}
+
+inline void AppendFixed(NumberText& text, double value, int decimals) {
+    auto result = std::to_chars(text.chars + text.length, text.chars + NumberText::kCapacity, value,
+        std::chars_format::fixed, decimals);
+    if (result.ec == std::errc()) text.length = (int)(result.ptr - text.chars);
+}
+
+inline void AppendInteger(NumberText& text, int64_t value) {
+    auto result = std::to_chars(text.chars + text.length, text.chars + NumberText::kCapacity, value);
+    if (result.ec == std::errc()) text.length = (int)(result.ptr - text.chars);
+}
+
+// Drop trailing zeros after the decimal point, and the point itself if
+// nothing is left after it, from the digits starting at `start`
+inline void TrimZeros(NumberText& text, int start) {
+    bool hasPoint = false;
+    for (int i = start; i < text.length; i++) hasPoint |= text.chars[i] == '.';
+    if (!hasPoint) return;
+    while (text.length > start && text.chars[text.length - 1] == '0') text.length--;
+    if (text.length > start && text.chars[text.length - 1] == '.') text.length--;
+}
+
+// mantissa in [1, 10), exponent in base 10; `trim` for Compact
+inline void AppendScientific(NumberText& text, double log10Value, bool trim) {
+    double exponent = std::floor(log10Value);
+    double mantissa = std::pow(10.0, log10Value - exponent);
+    if (mantissa >= 9.995) {
+        // Would print as 10.00
+        mantissa /= 10.0;
+        exponent += 1.0;
+    }
+    int start = text.length;
+    AppendFixed(text, mantissa, 2);
+    if (trim) TrimZeros(text, start);
+    Append(text, "e");
+    AppendInteger(text, (int64_t)exponent);
+}
+
+// Compact notation of a non-negative magnitude given as its log10 and, when
+// it fits, its double value
+inline void AppendCompact(NumberText& text, double value, double log10Value, int decimals) {
+    // Smallest value that would print as 1000 at this precision
+    double roundsToThousand = 1000.0 - 0.5 * std::pow(10.0, -decimals);
+    if (value < roundsToThousand) {
+        AppendFixed(text, value, decimals);
+        return;
+    }
+
+    int group = (int)std::floor(log10Value / 3.0);
+    if (group >= kSuffixCount) {
+        AppendScientific(text, log10Value, true);
+        return;
+    }
+
+    // Three significant digits; rounding can carry into the next group
+    double scaled = value / std::pow(10.0, 3.0 * group);
+    int digits = scaled >= 100.0 ? 0 : scaled >= 10.0 ? 1 : 2;
+    if (scaled >= 1000.0 - 0.5 * std::pow(10.0, -digits)) {
+        group++;
+        scaled /= 1000.0;
+        digits = 2;
+        if (group >= kSuffixCount) {
+            AppendScientific(text, log10Value, true);
+            return;
+        }
+    }
+    int start = text.length;
+    AppendFixed(text, scaled, digits);
+    TrimZeros(text, start);
+    Append(text, kSuffixes[group]);
+}
+
+} // namespace numberformat_detail
+
+// `decimals` applies to values shown in fixed notation (clamped to 0..9)
+inline NumberText FormatNumber(double value, int decimals, NumberNotation notation = NumberNotation::Full) {
+    using namespace numberformat_detail;
+    NumberText text;
+    decimals = decimals < 0 ? 0 : decimals > 9 ? 9 : decimals;
+
+    if (!std::isfinite(value)) {
+        Append(text, std::isnan(value) ? "nan" : value < 0.0 ? "-inf" : "inf");
+        return text;
+    }
+
+    double magnitude = std::fabs(value);
+    if (notation == NumberNotation::Full) {
+        if (magnitude < kFullLimit) {
+            AppendFixed(text, value, decimals);
+        }
+        else {
+            if (value < 0.0) Append(text, "-");
+            AppendScientific(text, std::log10(magnitude), false);
+        }
+        return text;
+    }
+
+    // Keep "-0.0" out of compact text
+    if (value < 0.0 && magnitude >= 0.5 * std::pow(10.0, -decimals)) Append(text, "-");
+    AppendCompact(text, magnitude, magnitude > 0.0 ? std::log10(magnitude) : 0.0, decimals);
+    return text;
+}
+
+inline NumberText FormatNumber(const BigNumber& value, int decimals, NumberNotation notation = NumberNotation::Full) {
+    using namespace numberformat_detail;
+    if (value.exponent == 0) return FormatNumber(value.mantissa, decimals, notation);
+
+    // Far beyond any suffix or fixed display
+    NumberText text;
+    if (value.IsNegative()) Append(text, "-");
+    AppendScientific(text, value.Log10(), notation == NumberNotation::Compact);
+    return text;
+}
+
+inline NumberText FormatInteger(int64_t value) {
+    NumberText text;
+    numberformat_detail::AppendInteger(text, value);
+    return text;
+}
+
+// Append to display text; allocates only if `out` has to grow
+inline void AppendNumber(std::wstring& out, const NumberText& text) {
+    for (int i = 0; i < text.length; i++) out.push_back((wchar_t)text.chars[i]);
+}
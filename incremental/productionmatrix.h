@@ -0,0 +1,330 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Costs and production of large content sets as sparse matrices.
+//
+// GameState sizes everything by kResourceCount and recalculates through the
+// ModifierGraph, which suits a handful of resources. Generated or modded
+// content can have hundreds of building types and dozens of resources, where
+// each building touches only a few of them. ProductionMatrix keeps both
+// tables in compressed sparse rows (one row per building, one column per
+// resource, zeros not stored) sized at run time:
+//
+//   flat       = baseRates + production^T * counts
+//   bonus      = bonus^T * counts + globalBonus . counts
+//   multiplier = exp(log1p(multiplier)^T * counts + log1p(globalMultiplier) . counts)
+//   rates      = flat * (1 + bonus) * multiplier
+//
+// which is the ModifierGraph formula (modifiers.h), with the compounding
+// multipliers summed as logarithms so they are linear in the counts too.
+// Rates agree with GameState's to within rounding, not bit for bit.
+//
+// Recompute() evaluates each product over the transposed matrix, so every
+// sum is one contiguous dot product with no scattered writes. A count
+// change is a rank-1 update: sums += delta * row[building], which touches
+// only the resources that building feeds (all of them when it has a global
+// modifier). Rank-1 updates round differently from a full product, so the
+// sums are recomputed from scratch every kRefreshInterval updates to keep
+// drift at a few ulps.
+//
+// Costs scale per building by growth^count; affordability checks and
+// purchases walk only the resources a building costs.
+
+// Compressed sparse rows
+struct SparseMatrix {
+    int rows = 0;
+    int columns = 0;
+    std::vector<int32_t> rowStart{ 0 };     // rows + 1 entries; row i is [rowStart[i], rowStart[i + 1])
+    std::vector<int32_t> column;
+    std::vector<double> value;
+
+    void Clear(int columnCount) {
+        rows = 0;
+        columns = columnCount;
+        rowStart.assign(1, 0);
+        column.clear();
+        value.clear();
+    }
+
+    // Append a row given densely; zeros are skipped
+    void AppendRow(const double* dense) {
+        for (int c = 0; c < columns; c++) {
+            if (dense[c] == 0.0) continue;
+            column.push_back(c);
+            value.push_back(dense[c]);
+        }
+        rowStart.push_back((int32_t)column.size());
+        rows++;
+    }
+
+    int RowBegin(int row) const { return rowStart[row]; }
+    int RowEnd(int row) const { return rowStart[row + 1]; }
+    int NonZeros() const { return (int)column.size(); }
+
+    // Value at (row, c), 0 if not stored
+    double At(int row, int c) const {
+        for (int k = RowBegin(row); k < RowEnd(row); k++) {
+            if (column[k] == c) return value[k];
+        }
+        return 0.0;
+    }
+
+    SparseMatrix Transposed() const {
+        SparseMatrix result;
+        result.rows = columns;
+        result.columns = rows;
+        result.rowStart.assign(columns + 1, 0);
+        for (int32_t c : column) result.rowStart[c + 1]++;
+        for (int c = 0; c < columns; c++) result.rowStart[c + 1] += result.rowStart[c];
+
+        // Rows are visited in order, so each transposed row stays sorted
+        result.column.resize(column.size());
+        result.value.resize(value.size());
+        std::vector<int32_t> next(result.rowStart.begin(), result.rowStart.end() - 1);
+        for (int r = 0; r < rows; r++) {
+            for (int k = RowBegin(r); k < RowEnd(r); k++) {
+                int32_t slot = next[column[k]]++;
+                result.column[slot] = r;
+                result.value[slot] = value[k];
+            }
+        }
+        return result;
+    }
+};
+
+// Production modifiers per building, as in BuildingType: additive bonuses
+// and compounding multipliers per resource, and global ones feeding every
+// resource. Empty matrices and vectors mean none.
+struct ProductionModifiers {
+    SparseMatrix bonus;                 // Building x resource, 0.1 = +10%
+    SparseMatrix multiplier;            // Building x resource, 0.1 = x1.1 per building
+    std::vector<double> globalBonus;
+    std::vector<double> globalMultiplier;
+};
+
+class ProductionMatrix {
+public:
+    // Rank-1 updates between full recomputes
+    static constexpr int kRefreshInterval = 4096;
+
+    // Updates applied since construction
+    int64_t rankOneUpdates = 0;
+    int64_t recomputes = 0;
+
+    // `production` and `cost` have one row per building and one column per
+    // resource; `growth` has one entry per building
+    void Build(const std::vector<double>& baseRates, const SparseMatrix& production, const SparseMatrix& cost,
+        const std::vector<double>& growth, const ProductionModifiers& modifiers = {}) {
+        base = baseRates;
+        productionRows = production;
+        productionColumns = production.Transposed();
+        costRows = cost;
+        costGrowth = growth;
+
+        int buildingCount = production.rows;
+        int resourceCount = (int)base.size();
+        bonusRows = modifiers.bonus.rows > 0 ? modifiers.bonus : EmptyRows(buildingCount, resourceCount);
+        bonusColumns = bonusRows.Transposed();
+        logMultiplierRows = modifiers.multiplier.rows > 0 ? modifiers.multiplier : EmptyRows(buildingCount, resourceCount);
+        for (double& value : logMultiplierRows.value) value = std::log1p(value);
+        logMultiplierColumns = logMultiplierRows.Transposed();
+
+        globalBonus.assign(buildingCount, 0.0);
+        globalLogMultiplier.assign(buildingCount, 0.0);
+        globalBuildings.clear();
+        for (int b = 0; b < buildingCount; b++) {
+            if (b < (int)modifiers.globalBonus.size()) globalBonus[b] = modifiers.globalBonus[b];
+            if (b < (int)modifiers.globalMultiplier.size()) globalLogMultiplier[b] = std::log1p(modifiers.globalMultiplier[b]);
+            if (globalBonus[b] != 0.0 || globalLogMultiplier[b] != 0.0) globalBuildings.push_back(b);
+        }
+
+        counts.assign(buildingCount, 0);
+        countValues.assign(buildingCount, 0.0);
+        costScale.assign(buildingCount, 1.0);
+        flat.assign(resourceCount, 0.0);
+        bonus.assign(resourceCount, 0.0);
+        logMultiplier.assign(resourceCount, 0.0);
+        rates.assign(resourceCount, 0.0);
+        Recompute();
+    }
+
+    // From a list of building types with dense production, cost, bonus and
+    // multiplier tables of `resourceCount` entries plus costGrowth,
+    // globalBonus and globalMultiplier, e.g. BuildingType
+    template <typename BuildingTypeList>
+    void Build(const std::vector<double>& baseRates, const BuildingTypeList& types) {
+        int resourceCount = (int)baseRates.size();
+        SparseMatrix production;
+        SparseMatrix cost;
+        ProductionModifiers modifiers;
+        production.Clear(resourceCount);
+        cost.Clear(resourceCount);
+        modifiers.bonus.Clear(resourceCount);
+        modifiers.multiplier.Clear(resourceCount);
+        std::vector<double> growth;
+        for (const auto& type : types) {
+            production.AppendRow(&type.production[0]);
+            cost.AppendRow(&type.cost[0]);
+            modifiers.bonus.AppendRow(&type.bonus[0]);
+            modifiers.multiplier.AppendRow(&type.multiplier[0]);
+            modifiers.globalBonus.push_back(type.globalBonus);
+            modifiers.globalMultiplier.push_back(type.globalMultiplier);
+            growth.push_back(type.costGrowth);
+        }
+        Build(baseRates, production, cost, growth, modifiers);
+    }
+
+    int BuildingCount() const { return (int)counts.size(); }
+    int ResourceCount() const { return (int)base.size(); }
+    int Count(int building) const { return counts[building]; }
+    const double* Rates() const { return rates.data(); }
+    const SparseMatrix& Production() const { return productionRows; }
+    const SparseMatrix& Cost() const { return costRows; }
+
+    // Every sum from scratch, then every rate
+    void Recompute() {
+        for (int r = 0; r < ResourceCount(); r++) {
+            flat[r] = base[r] + Dot(productionColumns, r);
+            bonus[r] = Dot(bonusColumns, r);
+            logMultiplier[r] = Dot(logMultiplierColumns, r);
+        }
+        globalBonusTotal = 0.0;
+        globalLogMultiplierTotal = 0.0;
+        for (int b : globalBuildings) {
+            globalBonusTotal += globalBonus[b] * countValues[b];
+            globalLogMultiplierTotal += globalLogMultiplier[b] * countValues[b];
+        }
+        for (int r = 0; r < ResourceCount(); r++) UpdateRate(r);
+        updatesSinceRefresh = 0;
+        recomputes++;
+    }
+
+    void SetCount(int building, int count) {
+        int delta = count - counts[building];
+        if (delta == 0) return;
+        counts[building] = count;
+        countValues[building] = count;
+        costScale[building] = std::pow(costGrowth[building], count);
+
+        if (++updatesSinceRefresh >= kRefreshInterval) {
+            Recompute();
+            return;
+        }
+        AddRow(productionRows, building, delta, flat);
+        AddRow(bonusRows, building, delta, bonus);
+        AddRow(logMultiplierRows, building, delta, logMultiplier);
+        if (globalBonus[building] != 0.0 || globalLogMultiplier[building] != 0.0) {
+            globalBonusTotal += globalBonus[building] * delta;
+            globalLogMultiplierTotal += globalLogMultiplier[building] * delta;
+            for (int r = 0; r < ResourceCount(); r++) UpdateRate(r);
+        }
+        else {
+            UpdateRates(productionRows, building);
+            UpdateRates(bonusRows, building);
+            UpdateRates(logMultiplierRows, building);
+        }
+        rankOneUpdates++;
+    }
+
+    // Cost of the next building of this type in one resource
+    double NextCost(int building, int resource) const {
+        return costRows.At(building, resource) * costScale[building];
+    }
+
+    bool CanAfford(int building, const double* amounts) const {
+        double scale = costScale[building];
+        for (int k = costRows.RowBegin(building); k < costRows.RowEnd(building); k++) {
+            if (amounts[costRows.column[k]] < costRows.value[k] * scale) return false;
+        }
+        return true;
+    }
+
+    // Deduct the next cost and add the building. Returns false, changing
+    // nothing, if it is not affordable.
+    bool Purchase(int building, double* amounts) {
+        if (!CanAfford(building, amounts)) return false;
+        double scale = costScale[building];
+        for (int k = costRows.RowBegin(building); k < costRows.RowEnd(building); k++) {
+            amounts[costRows.column[k]] -= costRows.value[k] * scale;
+        }
+        SetCount(building, counts[building] + 1);
+        return true;
+    }
+
+    // Seconds until the next building is affordable at the current rates;
+    // 0 if affordable now, infinity if never
+    double TimeUntilAffordable(int building, const double* amounts) const {
+        double scale = costScale[building];
+        double wait = 0.0;
+        for (int k = costRows.RowBegin(building); k < costRows.RowEnd(building); k++) {
+            double shortfall = costRows.value[k] * scale - amounts[costRows.column[k]];
+            if (shortfall <= 0.0) continue;
+            double rate = rates[costRows.column[k]];
+            if (rate <= 0.0) return std::numeric_limits<double>::infinity();
+            wait = std::max(wait, shortfall / rate);
+        }
+        return wait;
+    }
+
+private:
+    std::vector<double> base;
+    SparseMatrix productionRows;        // Building x resource, for rank-1 updates
+    SparseMatrix productionColumns;     // Resource x building, for Recompute
+    SparseMatrix bonusRows;
+    SparseMatrix bonusColumns;
+    SparseMatrix logMultiplierRows;     // log1p of the multipliers
+    SparseMatrix logMultiplierColumns;
+    std::vector<double> globalBonus;            // Per building
+    std::vector<double> globalLogMultiplier;    // Per building, log1p
+    std::vector<int> globalBuildings;           // Buildings with either
+    SparseMatrix costRows;
+    std::vector<double> costGrowth;
+
+    std::vector<int> counts;
+    std::vector<double> countValues;    // counts as doubles, read by Recompute
+    std::vector<double> costScale;      // growth^count per building
+    std::vector<double> flat;
+    std::vector<double> bonus;
+    std::vector<double> logMultiplier;
+    double globalBonusTotal = 0.0;
+    double globalLogMultiplierTotal = 0.0;
+    std::vector<double> rates;
+    int updatesSinceRefresh = 0;
+
+    static SparseMatrix EmptyRows(int rows, int columns) {
+        SparseMatrix matrix;
+        matrix.Clear(columns);
+        matrix.rows = rows;
+        matrix.rowStart.assign(rows + 1, 0);
+        return matrix;
+    }
+
+    // Row r of a transposed matrix times the counts
+    double Dot(const SparseMatrix& columns, int r) const {
+        const int32_t* column = columns.column.data();
+        const double* value = columns.value.data();
+        const double* count = countValues.data();
+        double sum = 0.0;
+        for (int k = columns.rowStart[r]; k < columns.rowStart[r + 1]; k++) sum += value[k] * count[column[k]];
+        return sum;
+    }
+
+    static void AddRow(const SparseMatrix& matrix, int building, int delta, std::vector<double>& sums) {
+        for (int k = matrix.RowBegin(building); k < matrix.RowEnd(building); k++) {
+            sums[matrix.column[k]] += matrix.value[k] * delta;
+        }
+    }
+
+    void UpdateRates(const SparseMatrix& matrix, int building) {
+        for (int k = matrix.RowBegin(building); k < matrix.RowEnd(building); k++) UpdateRate(matrix.column[k]);
+    }
+
+    void UpdateRate(int r) {
+        double multiplier = logMultiplier[r] + globalLogMultiplierTotal;
+        rates[r] = flat[r] * (1.0 + bonus[r] + globalBonusTotal) * (multiplier == 0.0 ? 1.0 : std::exp(multiplier));
+    }
+};
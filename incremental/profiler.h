@@ -0,0 +1,227 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Built-in profiler for the hot paths: scoped zone timers and counters,
+// recorded per thread and exported as Chrome trace JSON (load the file in
+// chrome://tracing or https://ui.perfetto.dev).
+//
+// Recording is off until Profiler::SetEnabled(true). While off, a zone or
+// counter costs one relaxed atomic load and a branch. Building with
+// INCREMENTAL_NO_PROFILER removes them entirely.
+//
+// Each thread writes only to its own ring buffer, with no locks and no
+// allocation after its first event; when a ring is full the oldest events
+// are overwritten. Export can run on any thread while others record.
+
+enum class ProfileEventType : uint8_t {
+    Zone,           // value is the duration in nanoseconds
+    Counter
+};
+
+struct ProfileEvent {
+    const char* name;       // Must outlive the profiler (string literals)
+    int64_t start;          // Nanoseconds since the profiler started
+    int64_t value;
+    ProfileEventType type;
+};
+
+// One thread's events. Written by its thread only.
+class ProfileBuffer {
+public:
+    static constexpr size_t kCapacity = 1 << 16;
+
+    uint32_t threadId;
+    std::string threadName;
+
+    explicit ProfileBuffer(uint32_t threadId)
+        : threadId(threadId), threadName("Thread " + std::to_string(threadId)), events(new ProfileEvent[kCapacity]) {
+    }
+
+    void Push(const ProfileEvent& event) {
+        uint64_t index = written.load(std::memory_order_relaxed);
+        events[index & (kCapacity - 1)] = event;
+        written.store(index + 1, std::memory_order_release);
+    }
+
+    // Copy out the events still in the ring. Events the owner overwrote
+    // while copying are dropped.
+    void Collect(std::vector<ProfileEvent>& out) const {
+        uint64_t end = written.load(std::memory_order_acquire);
+        uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+        size_t first = out.size();
+        for (uint64_t i = begin; i < end; i++) out.push_back(events[i & (kCapacity - 1)]);
+
+        uint64_t after = written.load(std::memory_order_acquire);
+        uint64_t overwritten = after > kCapacity ? after - kCapacity : 0;
+        if (overwritten > begin) {
+            size_t drop = (size_t)std::min(overwritten - begin, end - begin);
+            out.erase(out.begin() + first, out.begin() + first + drop);
+        }
+    }
+
+private:
+    std::unique_ptr<ProfileEvent[]> events;
+    std::atomic<uint64_t> written{ 0 };
+};
+
+class Profiler {
+public:
+    static Profiler& Instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    static bool Enabled() { return enabled.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+
+    static int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Instance().epoch).count();
+    }
+
+    static void Zone(const char* name, int64_t start, int64_t duration) {
+        ThisThread().Push(ProfileEvent{ name, start, duration, ProfileEventType::Zone });
+    }
+
+    static void Counter(const char* name, int64_t value) {
+        ThisThread().Push(ProfileEvent{ name, Now(), value, ProfileEventType::Counter });
+    }
+
+    // Shown as the calling thread's name in the trace. Does not create the
+    // thread's buffer, so threads that never record cost nothing.
+    static void SetThreadName(const char* name) {
+        threadName = name;
+        if (!threadBuffer) return;
+        std::lock_guard<std::mutex> lock(Instance().mutex);
+        threadBuffer->threadName = name;
+    }
+
+    // The calling thread's buffer, created on first use
+    static ProfileBuffer& ThisThread() {
+        if (!threadBuffer) threadBuffer = Instance().Register(threadName);
+        return *threadBuffer;
+    }
+
+    // Write every recorded event as Chrome trace JSON
+    bool WriteChromeTrace(const std::string& path) const {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+
+        std::vector<ProfileEvent> events;
+        std::lock_guard<std::mutex> lock(mutex);
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        bool first = true;
+        for (const auto& buffer : buffers) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", buffer->threadId, buffer->threadName.c_str());
+            first = false;
+
+            events.clear();
+            buffer->Collect(events);
+            for (const ProfileEvent& event : events) {
+                if (event.type == ProfileEventType::Zone) {
+                    fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                        event.name, buffer->threadId, event.start / 1000.0, event.value / 1000.0);
+                }
+                else {
+                    fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+                        event.name, buffer->threadId, event.start / 1000.0, (long long)event.value);
+                }
+            }
+        }
+        fprintf(file, "\n]}\n");
+        return fclose(file) == 0;
+    }
+
+private:
+    static inline std::atomic<bool> enabled{ false };
+    static inline thread_local ProfileBuffer* threadBuffer = nullptr;
+    static inline thread_local const char* threadName = nullptr;
+
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<ProfileBuffer>> buffers;    // Kept after their thread exits
+
+    ProfileBuffer* Register(const char* name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(std::make_unique<ProfileBuffer>((uint32_t)buffers.size() + 1));
+        if (name) buffers.back()->threadName = name;
+        return buffers.back().get();
+    }
+};
+
+// Times the enclosing scope
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : name(name), start(Profiler::Enabled() ? Profiler::Now() : -1) {}
+
+    ~ProfileZone() {
+        if (start >= 0) Profiler::Zone(name, start, Profiler::Now() - start);
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    int64_t start;
+};
+
+#ifdef INCREMENTAL_NO_PROFILER
+#define PROFILE_ZONE(name)
+#define PROFILE_COUNTER(name, value)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) \
+    do { if (Profiler::Enabled()) Profiler::Counter(name, (int64_t)(value)); } while (0)
+#endif
+
+// Frame times over a sliding window, bucketed so percentiles and the
+// overlay histogram cost O(buckets) and never allocate
+class FrameTimeStats {
+public:
+    static constexpr int kWindow = 600;                 // Frames kept (10 s at 60 FPS)
+    static constexpr double kBucketMillis = 0.25;
+    static constexpr int kBucketCount = 256;            // Up to 64 ms; slower frames land in the last bucket
+
+    void Add(double seconds) {
+        int bucket = std::clamp((int)(seconds * 1000.0 / kBucketMillis), 0, kBucketCount - 1);
+        if (count == kWindow) buckets[samples[next]]--;
+        else count++;
+        samples[next] = (uint16_t)bucket;
+        buckets[bucket]++;
+        next = (next + 1) % kWindow;
+    }
+
+    int Count() const { return count; }
+
+    // Upper edge of the bucket holding the given fraction of frames
+    double PercentileMillis(double fraction) const {
+        if (count == 0) return 0.0;
+        int target = std::max(1, (int)std::ceil(fraction * count));
+        int seen = 0;
+        for (int b = 0; b < kBucketCount; b++) {
+            seen += buckets[b];
+            if (seen >= target) return (b + 1) * kBucketMillis;
+        }
+        return kBucketCount * kBucketMillis;
+    }
+
+    int Bucket(int index) const { return buckets[index]; }
+
+private:
+    uint16_t samples[kWindow] = {};
+    int buckets[kBucketCount] = {};
+    int count = 0;
+    int next = 0;
+};
@@ -0,0 +1,303 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Backend-agnostic drawing. The UI records a RenderList each frame; the
+// Renderer compares it with the previous frame and hands a backend only the
+// regions that changed. Backends keep their own resources (fonts, brushes,
+// back buffer) alive between frames.
+
+// 0xAARRGGBB
+using RenderColor = uint32_t;
+
+constexpr RenderColor MakeColor(int a, int r, int g, int b) {
+    return ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+}
+
+struct RenderRect {
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+
+    float Right() const { return x + width; }
+    float Bottom() const { return y + height; }
+    bool IsEmpty() const { return width <= 0.0f || height <= 0.0f; }
+
+    bool Intersects(const RenderRect& other) const {
+        return x < other.Right() && other.x < Right() && y < other.Bottom() && other.y < Bottom();
+    }
+
+    static RenderRect Union(const RenderRect& a, const RenderRect& b) {
+        if (a.IsEmpty()) return b;
+        if (b.IsEmpty()) return a;
+        float left = std::min(a.x, b.x);
+        float top = std::min(a.y, b.y);
+        return RenderRect{ left, top, std::max(a.Right(), b.Right()) - left, std::max(a.Bottom(), b.Bottom()) - top };
+    }
+
+    bool operator==(const RenderRect& other) const {
+        return x == other.x && y == other.y && width == other.width && height == other.height;
+    }
+};
+
+// Fonts are a fixed set, so backends can create them once
+enum class RenderFont : uint8_t {
+    Title,
+    Resource,
+    Small,
+    Button,
+    Tiny,
+    Count
+};
+
+struct RenderFontInfo {
+    const wchar_t* family;
+    float pixelSize;
+    bool bold;
+};
+
+inline const RenderFontInfo& GetFontInfo(RenderFont font) {
+    static const RenderFontInfo fonts[(int)RenderFont::Count] = {
+        { L"Arial", 24.0f, true },      // Title
+        { L"Arial", 18.0f, false },     // Resource
+        { L"Arial", 14.0f, false },     // Small
+        { L"Arial", 14.0f, true },      // Button
+        { L"Arial", 11.0f, false },     // Tiny
+    };
+    return fonts[(int)font];
+}
+
+enum class RenderCommandType : uint8_t {
+    FillRect,
+    StrokeRect,     // Outline centred on the rect edge, penWidth wide
+    Text            // Laid out inside rect, clipped to it
+};
+
+enum class TextAlign : uint8_t {
+    TopLeft,
+    Center
+};
+
+struct RenderCommand {
+    RenderCommandType type;
+    RenderFont font;
+    TextAlign align;
+    RenderColor color;
+    float penWidth;
+    RenderRect rect;
+    uint32_t textOffset;        // Into RenderList::text
+    uint32_t textLength;
+
+    // Pixels this command can touch
+    RenderRect Bounds() const {
+        if (type != RenderCommandType::StrokeRect) return rect;
+        float half = penWidth * 0.5f + 1.0f;     // Plus a pixel of antialiasing
+        return RenderRect{ rect.x - half, rect.y - half, rect.width + 2.0f * half, rect.height + 2.0f * half };
+    }
+};
+
+// One frame of drawing. Strings are copied into a single arena so the list
+// owns everything it refers to; after the first few frames recording does
+// not allocate.
+class RenderList {
+public:
+    std::vector<RenderCommand> commands;
+    std::wstring text;
+
+    void Clear() {
+        commands.clear();
+        text.clear();
+    }
+
+    void FillRect(const RenderRect& rect, RenderColor color) {
+        commands.push_back(Make(RenderCommandType::FillRect, rect, color));
+    }
+
+    void StrokeRect(const RenderRect& rect, RenderColor color, float penWidth) {
+        RenderCommand command = Make(RenderCommandType::StrokeRect, rect, color);
+        command.penWidth = penWidth;
+        commands.push_back(command);
+    }
+
+    void Text(const std::wstring& value, const RenderRect& rect, RenderFont font, RenderColor color,
+        TextAlign align = TextAlign::TopLeft) {
+        Text(value.data(), value.size(), rect, font, color, align);
+    }
+
+    void Text(const wchar_t* value, size_t length, const RenderRect& rect, RenderFont font, RenderColor color,
+        TextAlign align = TextAlign::TopLeft) {
+        RenderCommand command = Make(RenderCommandType::Text, rect, color);
+        command.font = font;
+        command.align = align;
+        command.textOffset = (uint32_t)text.size();
+        command.textLength = (uint32_t)length;
+        text.append(value, length);
+        commands.push_back(command);
+    }
+
+    const wchar_t* TextOf(const RenderCommand& command) const { return text.data() + command.textOffset; }
+
+    // Same drawing, ignoring where the text happens to sit in the arena
+    bool SameCommand(size_t index, const RenderList& other, size_t otherIndex) const {
+        const RenderCommand& a = commands[index];
+        const RenderCommand& b = other.commands[otherIndex];
+        if (a.type != b.type || a.color != b.color || !(a.rect == b.rect)) return false;
+        if (a.type == RenderCommandType::StrokeRect) return a.penWidth == b.penWidth;
+        if (a.type != RenderCommandType::Text) return true;
+        return a.font == b.font && a.align == b.align && a.textLength == b.textLength
+            && memcmp(TextOf(a), other.TextOf(b), a.textLength * sizeof(wchar_t)) == 0;
+    }
+
+private:
+    static RenderCommand Make(RenderCommandType type, const RenderRect& rect, RenderColor color) {
+        RenderCommand command = {};
+        command.type = type;
+        command.rect = rect;
+        command.color = color;
+        return command;
+    }
+};
+
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    // Redraw the parts of the frame inside `dirty`: every command that
+    // intersects a dirty rect, in order, clipped to the dirty rects
+    virtual void Draw(const RenderList& list, const std::vector<RenderRect>& dirty, int width, int height) = 0;
+};
+
+// Finds what changed between frames and sends only that to the backend
+class Renderer {
+public:
+    // Beyond this many separate regions, redraw their union instead
+    static constexpr size_t kMaxDirtyRects = 8;
+
+    // Once the changed area reaches this share of the window, the rest of the
+    // diff is skipped and the whole window is redrawn: clipping every command
+    // to the regions costs more than it saves (see bench/render_bench.cpp)
+    static constexpr double kFullRedrawFraction = 0.8;
+    double fullRedrawFraction = kFullRedrawFraction;
+
+    // Statistics for the last frame
+    size_t commandsRecorded = 0;
+    size_t commandsChanged = 0;
+    double dirtyFraction = 0.0;         // Share of the window redrawn
+    bool redrewAll = false;             // Diff skipped or given up on
+
+    // Draw a newly recorded frame. `list` is swapped with the previous
+    // frame's list, so the caller can reuse its buffers for the next frame.
+    // Returns the regions that were redrawn (empty if nothing changed).
+    const std::vector<RenderRect>& Submit(RenderList& list, int width, int height, RenderBackend& backend) {
+        dirty.clear();
+        commandsRecorded = list.commands.size();
+        commandsChanged = 0;
+
+        bool fullRedraw = width != lastWidth || height != lastHeight || list.commands.size() != previous.commands.size();
+        double windowArea = (double)width * height;
+        double fullRedrawArea = fullRedrawFraction * windowArea;
+        if (fullRedraw) {
+            commandsChanged = list.commands.size();
+        }
+        else {
+            // Overlapping changes are counted twice here, so a frame can give
+            // up on the diff a little early; the merged regions are checked
+            // against the same limit below
+            double changedArea = 0.0;
+            for (size_t i = 0; i < list.commands.size(); i++) {
+                if (list.SameCommand(i, previous, i)) continue;
+                commandsChanged++;
+                RenderRect rect = RenderRect::Union(list.commands[i].Bounds(), previous.commands[i].Bounds());
+                changedArea += (double)rect.width * rect.height;
+                if (changedArea >= fullRedrawArea) {
+                    fullRedraw = true;
+                    break;
+                }
+                AddDirty(rect);
+            }
+            if (!fullRedraw) {
+                MergeDirty();
+                fullRedraw = !dirty.empty() && Area() >= fullRedrawArea;
+            }
+        }
+        if (fullRedraw) dirty.assign(1, RenderRect{ 0.0f, 0.0f, (float)width, (float)height });
+        redrewAll = fullRedraw;
+
+        dirtyFraction = windowArea > 0.0 ? std::min(1.0, Area() / windowArea) : 0.0;
+
+        if (!dirty.empty()) backend.Draw(list, dirty, width, height);
+
+        lastWidth = width;
+        lastHeight = height;
+        std::swap(previous, list);
+        return dirty;
+    }
+
+    // Force the next frame to redraw everything (e.g. the window was exposed)
+    void Invalidate() { lastWidth = -1; }
+
+private:
+    RenderList previous;
+    std::vector<RenderRect> dirty;
+    int lastWidth = -1;
+    int lastHeight = -1;
+
+    double Area() const {
+        double area = 0.0;
+        for (const auto& rect : dirty) area += (double)rect.width * rect.height;
+        return area;
+    }
+
+    void AddDirty(const RenderRect& rect) {
+        if (!rect.IsEmpty()) dirty.push_back(rect);
+    }
+
+    // Merge overlapping regions; too many small ones become one
+    void MergeDirty() {
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (size_t i = 0; i < dirty.size() && !merged; i++) {
+                for (size_t j = i + 1; j < dirty.size(); j++) {
+                    if (!dirty[i].Intersects(dirty[j])) continue;
+                    dirty[i] = RenderRect::Union(dirty[i], dirty[j]);
+                    dirty.erase(dirty.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+
+        if (dirty.size() > kMaxDirtyRects) {
+            RenderRect all;
+            for (const auto& rect : dirty) all = RenderRect::Union(all, rect);
+            dirty.assign(1, all);
+        }
+    }
+};
+
+// Draws nothing; counts what a real backend would have done. For headless
+// benchmarks and tests of the UI's render cost.
+class NullRenderBackend : public RenderBackend {
+public:
+    int64_t frames = 0;
+    int64_t commandsDrawn = 0;
+    int64_t charactersDrawn = 0;
+
+    void Draw(const RenderList& list, const std::vector<RenderRect>& dirty, int, int) override {
+        frames++;
+        for (const auto& command : list.commands) {
+            RenderRect bounds = command.Bounds();
+            bool visible = false;
+            for (const auto& rect : dirty) visible |= bounds.Intersects(rect);
+            if (!visible) continue;
+
+            commandsDrawn++;
+            if (command.type == RenderCommandType::Text) charactersDrawn += command.textLength;
+        }
+    }
+};
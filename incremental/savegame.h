@@ -0,0 +1,483 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <thread>
+#include <vector>
+#include "game.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Binary save format
+//
+//   SaveHeader                      fixed 48 bytes
+//   SaveResource[resourceCount]     16 bytes each (BigNumber as stored)
+//   int32_t[buildingCount]          building counts, padded to 8 bytes
+//   uint64_t[buildingCount]         BuildingNameHash of each count (version 2)
+//
+// All fields are little-endian and naturally aligned, so a loaded file is
+// used in place through a memory mapping; nothing is parsed field by field.
+// The checksum covers everything after the header.
+//
+// Counts are matched to buildings by name, as ApplyDefinitions does on
+// reload, so adding or reordering buildings in the definitions keeps every
+// count on its building. Version 1 saves carry no names and restore by
+// position.
+const uint32_t kSaveMagic = 0x53434e49;    // "INCS"
+const uint32_t kSaveVersion = 2;
+const uint32_t kSaveVersionPositional = 1;
+
+struct SaveHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t resourceCount;
+    uint32_t buildingCount;
+    uint32_t reserved;
+    double gameTime;
+    uint64_t payloadSize;
+    uint64_t checksum;
+};
+static_assert(sizeof(SaveHeader) == 48, "SaveHeader layout is part of the file format");
+
+struct SaveResource {
+    double mantissa;
+    int64_t exponent;
+};
+static_assert(sizeof(SaveResource) == 16, "SaveResource layout is part of the file format");
+
+// Everything a save holds, detached from GameState so it can be written on
+// another thread
+struct SaveData {
+    double gameTime = 0.0;
+    ResourceAmounts amounts;
+    std::vector<int32_t> counts;
+    std::vector<uint64_t> buildingNames;    // BuildingNameHash per count; empty to restore by position
+};
+
+// 64-bit FNV-1a over the name's code points, so the hash is the same
+// whether wchar_t holds UTF-16 or UTF-32
+inline uint64_t BuildingNameHash(const std::wstring& name) {
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < name.size(); i++) {
+        uint32_t point = (uint32_t)name[i];
+        if (point >= 0xd800 && point < 0xdc00 && i + 1 < name.size() && (uint32_t)name[i + 1] >= 0xdc00 &&
+            (uint32_t)name[i + 1] < 0xe000) {
+            point = 0x10000 + ((point - 0xd800) << 10) + ((uint32_t)name[++i] - 0xdc00);
+        }
+        hash = (hash ^ point) * 1099511628211ull;
+    }
+    return hash;
+}
+
+inline SaveData CaptureSave(const GameState& game) {
+    SaveData save;
+    save.gameTime = game.gameTime;
+    save.amounts = game.amounts;
+    save.counts.reserve(game.buildings.size());
+    save.buildingNames.reserve(game.buildings.size());
+    for (const auto& building : game.buildings) {
+        save.counts.push_back(building.count);
+        save.buildingNames.push_back(BuildingNameHash(building.type->name));
+    }
+    return save;
+}
+
+// Set building counts from a save. With names, each count goes to the
+// building of that name, and saved buildings the content no longer has are
+// dropped; without, counts go by position. Buildings the save does not
+// mention are left alone.
+inline void ApplySavedCounts(const int32_t* counts, const uint64_t* names, size_t count, GameState& game) {
+    if (!names) {
+        size_t buildingCount = std::min(count, game.buildings.size());
+        for (size_t b = 0; b < buildingCount; b++) game.buildings[b].count = counts[b];
+        return;
+    }
+
+    std::unordered_map<uint64_t, size_t> indexByName;
+    indexByName.reserve(game.buildings.size());
+    for (size_t b = 0; b < game.buildings.size(); b++) indexByName.emplace(BuildingNameHash(game.buildings[b].type->name), b);
+    for (size_t i = 0; i < count; i++) {
+        auto found = indexByName.find(names[i]);
+        if (found != indexByName.end()) game.buildings[found->second].count = counts[i];
+    }
+}
+
+// Restore a game from save data
+inline void ApplySaveData(const SaveData& save, GameState& game) {
+    game.gameTime = (float)save.gameTime;
+    game.amounts = save.amounts;
+
+    bool named = save.buildingNames.size() == save.counts.size();
+    ApplySavedCounts(save.counts.data(), named ? save.buildingNames.data() : nullptr, save.counts.size(), game);
+    game.RecalculateProduction();
+    game.MarkAllChanged();
+}
+
+// 64-bit FNV-1a over 8-byte words (size must be a multiple of 8)
+inline uint64_t SaveChecksum(const void* data, size_t size) {
+    uint64_t hash = 1469598103934665603ull;
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return hash;
+}
+
+inline size_t SaveCountBytes(size_t buildingCount) {
+    return (buildingCount * sizeof(int32_t) + 7) & ~(size_t)7;
+}
+
+inline size_t SavePayloadSize(size_t buildingCount, uint32_t version = kSaveVersion) {
+    size_t nameBytes = version == kSaveVersionPositional ? 0 : buildingCount * sizeof(uint64_t);
+    return kResourceCount * sizeof(SaveResource) + SaveCountBytes(buildingCount) + nameBytes;
+}
+
+// Serialize a save into one contiguous buffer; a save without names is
+// written as version 1
+inline std::vector<unsigned char> EncodeSave(const SaveData& save) {
+    bool named = save.buildingNames.size() == save.counts.size();
+    uint32_t version = named ? kSaveVersion : kSaveVersionPositional;
+    size_t payloadSize = SavePayloadSize(save.counts.size(), version);
+    std::vector<unsigned char> buffer(sizeof(SaveHeader) + payloadSize, 0);
+
+    unsigned char* payload = buffer.data() + sizeof(SaveHeader);
+    SaveResource* resources = (SaveResource*)payload;
+    for (int r = 0; r < kResourceCount; r++) {
+        resources[r].mantissa = save.amounts[r].mantissa;
+        resources[r].exponent = save.amounts[r].exponent;
+    }
+    if (!save.counts.empty()) {
+        memcpy(payload + kResourceCount * sizeof(SaveResource), save.counts.data(), save.counts.size() * sizeof(int32_t));
+    }
+    if (named && !save.buildingNames.empty()) {
+        memcpy(payload + kResourceCount * sizeof(SaveResource) + SaveCountBytes(save.counts.size()),
+            save.buildingNames.data(), save.buildingNames.size() * sizeof(uint64_t));
+    }
+
+    SaveHeader header = {};
+    header.magic = kSaveMagic;
+    header.version = version;
+    header.headerSize = sizeof(SaveHeader);
+    header.resourceCount = kResourceCount;
+    header.buildingCount = (uint32_t)save.counts.size();
+    header.gameTime = save.gameTime;
+    header.payloadSize = payloadSize;
+    header.checksum = SaveChecksum(payload, payloadSize);
+    memcpy(buffer.data(), &header, sizeof(header));
+    return buffer;
+}
+
+// Write to "<path>.tmp", flush it to disk, then rename over path. A crash
+// at any point leaves either the old save or the new one, never a torn file.
+// On POSIX the directory is synced after the rename, so once this returns
+// the new file also survives a power loss; on Windows the rename itself is
+// not flushed and a power loss right after can still bring back the old one.
+inline bool WriteFileAtomic(const std::string& path, const void* data, size_t size) {
+    std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+
+    bool ok = fwrite(data, 1, size, file) == size && fflush(file) == 0;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(file)) == 0;
+#else
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) return false;
+
+#ifndef _WIN32
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    int directoryFd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (directoryFd < 0) return false;
+    ok = fsync(directoryFd) == 0;
+    close(directoryFd);
+#endif
+    return ok;
+}
+
+inline bool WriteSave(const std::string& path, const SaveData& save) {
+    std::vector<unsigned char> buffer = EncodeSave(save);
+    return WriteFileAtomic(path, buffer.data(), buffer.size());
+}
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path) {
+        Close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+            Close();
+            return false;
+        }
+        size = (size_t)fileSize.QuadPart;
+
+        mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mappingHandle) {
+            Close();
+            return false;
+        }
+        data = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        size = (size_t)info.st_size;
+
+        void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        data = mapping == MAP_FAILED ? nullptr : (const unsigned char*)mapping;
+#endif
+        if (!data) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mappingHandle) CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mappingHandle = NULL;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap((void*)data, size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    const unsigned char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = NULL;
+#endif
+};
+
+// A validated save, read in place from a memory-mapped file
+class LoadedSave {
+public:
+    // Map and validate a save file. Fails on a missing file, wrong magic,
+    // unknown version, truncated payload or checksum mismatch.
+    bool Open(const std::string& path) {
+        header = nullptr;
+        if (!file.Open(path)) return false;
+        return Validate(file.Data(), file.Size());
+    }
+
+    // Validate a save already in memory (the buffer must outlive this object)
+    bool Validate(const unsigned char* bytes, size_t size) {
+        header = nullptr;
+        if (size < sizeof(SaveHeader)) return false;
+
+        const SaveHeader* candidate = (const SaveHeader*)bytes;
+        if (candidate->magic != kSaveMagic) return false;
+        if (candidate->version != kSaveVersion && candidate->version != kSaveVersionPositional) return false;
+        if (candidate->headerSize != sizeof(SaveHeader) || candidate->resourceCount != kResourceCount) return false;
+        if (candidate->payloadSize != SavePayloadSize(candidate->buildingCount, candidate->version)) return false;
+        if (size < sizeof(SaveHeader) + candidate->payloadSize) return false;
+
+        const unsigned char* payload = bytes + sizeof(SaveHeader);
+        if (SaveChecksum(payload, candidate->payloadSize) != candidate->checksum) return false;
+
+        // The checksum only catches damage; the values must also make sense
+        const auto* candidateResources = (const SaveResource*)payload;
+        const auto* candidateCounts = (const int32_t*)(payload + kResourceCount * sizeof(SaveResource));
+        if (!std::isfinite(candidate->gameTime)) return false;
+        for (int r = 0; r < kResourceCount; r++) {
+            if (!std::isfinite(candidateResources[r].mantissa) || candidateResources[r].mantissa < 0.0) return false;
+        }
+        for (uint32_t b = 0; b < candidate->buildingCount; b++) {
+            if (candidateCounts[b] < 0) return false;
+        }
+
+        header = candidate;
+        resources = candidateResources;
+        counts = candidateCounts;
+        names = candidate->version == kSaveVersionPositional ? nullptr
+            : (const uint64_t*)(payload + kResourceCount * sizeof(SaveResource) + SaveCountBytes(candidate->buildingCount));
+        return true;
+    }
+
+    bool IsValid() const { return header != nullptr; }
+    double GameTime() const { return header->gameTime; }
+    uint32_t BuildingCount() const { return header->buildingCount; }
+    uint64_t Checksum() const { return header->checksum; }
+    size_t Bytes() const { return sizeof(SaveHeader) + header->payloadSize; }
+    const int32_t* Counts() const { return counts; }
+    const uint64_t* BuildingNames() const { return names; }     // nullptr for a version 1 save
+
+    BigNumber Amount(int resource) const {
+        BigNumber value;
+        value.mantissa = resources[resource].mantissa;
+        value.exponent = resources[resource].exponent;
+        return value;
+    }
+
+    // Copy out of the mapping
+    SaveData ToSaveData() const {
+        SaveData save;
+        save.gameTime = header->gameTime;
+        for (int r = 0; r < kResourceCount; r++) save.amounts[r] = Amount(r);
+        save.counts.assign(counts, counts + header->buildingCount);
+        if (names) save.buildingNames.assign(names, names + header->buildingCount);
+        return save;
+    }
+
+    // Restore a game, reading straight from the mapping (same rules as ApplySaveData)
+    void ApplyTo(GameState& game) const {
+        game.gameTime = (float)header->gameTime;
+        for (int r = 0; r < kResourceCount; r++) game.amounts[r] = Amount(r);
+
+        ApplySavedCounts(counts, names, header->buildingCount, game);
+        game.RecalculateProduction();
+        game.MarkAllChanged();
+    }
+
+private:
+    MappedFile file;
+    const SaveHeader* header = nullptr;
+    const SaveResource* resources = nullptr;
+    const int32_t* counts = nullptr;
+    const uint64_t* names = nullptr;
+};
+
+inline bool LoadGame(const std::string& path, GameState& game) {
+    LoadedSave save;
+    if (!save.Open(path)) return false;
+    save.ApplyTo(game);
+    return true;
+}
+
+// Writes saves on a background thread so the main loop never waits on disk.
+// RequestSave() only copies the compact SaveData and hands it over; if a
+// write is still in progress, newer requests replace older pending ones.
+// `afterSave`, if set, runs on the worker after each successful write, e.g.
+// to push a snapshot to sync storage (snapshots.h).
+class AutosaveWorker {
+public:
+    explicit AutosaveWorker(const std::string& path, std::function<void(const SaveData&)> afterSave = nullptr)
+        : path(path), afterSave(std::move(afterSave)) {
+        worker = std::thread([this] { WorkerLoop(); });
+    }
+
+    ~AutosaveWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    AutosaveWorker(const AutosaveWorker&) = delete;
+    AutosaveWorker& operator=(const AutosaveWorker&) = delete;
+
+    void RequestSave(const GameState& game) {
+        SaveData save = CaptureSave(game);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = std::move(save);
+            hasPending = true;
+        }
+        wake.notify_one();
+    }
+
+    // Block until every requested save has been written
+    void Flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return !hasPending && !writing; });
+    }
+
+    uint64_t SavesWritten() const { return savesWritten; }
+    uint64_t SavesFailed() const { return savesFailed; }
+
+private:
+    std::string path;
+    std::function<void(const SaveData&)> afterSave;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    SaveData pending;
+    bool hasPending = false;
+    bool writing = false;
+    bool stopping = false;
+    std::atomic<uint64_t> savesWritten{ 0 };
+    std::atomic<uint64_t> savesFailed{ 0 };
+
+    void WorkerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || hasPending; });
+            if (!hasPending) return;
+
+            SaveData save = std::move(pending);
+            hasPending = false;
+            writing = true;
+            lock.unlock();
+
+            if (WriteSave(path, save)) {
+                savesWritten++;
+                if (afterSave) afterSave(save);
+            }
+            else {
+                savesFailed++;
+            }
+
+            lock.lock();
+            writing = false;
+            idle.notify_all();
+        }
+    }
+};
\ No newline at end of file
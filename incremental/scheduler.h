@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <vector>
+#include "game.h"
+
+// Predicts the moment each building becomes affordable, so the UI and
+// automation can react on the right tick instead of polling CanAfford.
+//
+// Between purchases, gathers and rate changes every stockpile grows
+// linearly, so the time a cost is reached follows from
+// GameState::TimeUntilAffordable. Predictions are kept in a min-heap keyed
+// on absolute time and are only recomputed when the GameState change
+// counters say an input moved:
+//  - a rate change (every purchase recalculates production) or new content
+//    recomputes every building;
+//  - a gather or other adjustment of one resource recomputes only the
+//    buildings whose cost uses that resource.
+// Plain ticks change nothing here. A frame with no events costs a handful of
+// counter comparisons and a look at the top of the heap.
+//
+// Times are on the caller's clock (`now`, in seconds); it only has to
+// advance at the same rate as the game.
+class AffordabilityScheduler {
+public:
+    static constexpr double kNever = std::numeric_limits<double>::infinity();
+
+    // Bring predictions up to date. Buildings whose affordable state flipped
+    // since the last call are appended to `changed` (if given).
+    void Update(const GameState& game, double now, std::vector<int>* changed = nullptr) {
+        if (game.contentVersion != contentVersion || entries.size() != game.buildings.size()) {
+            Rebuild(game);
+            RecomputeAll(game, now, changed);
+        }
+        else if (game.ratesVersion != ratesVersion) {
+            RecomputeAll(game, now, changed);
+        }
+        else {
+            for (int r = 0; r < kResourceCount; r++) {
+                if (game.adjustmentVersions[r] == adjustmentVersions[r]) continue;
+                for (int index : usersOf[r]) Recompute(game, index, now, changed);
+            }
+        }
+        adjustmentVersions = game.adjustmentVersions;
+
+        // Fire everything that is due. A prediction can land a hair early
+        // (per-frame integration rounds differently from the closed form);
+        // those are re-predicted instead of reported.
+        while (!queue.empty() && queue.top().time <= now) {
+            Event event = queue.top();
+            queue.pop();
+            Entry& entry = entries[event.index];
+            if (event.generation != entry.generation) continue;
+
+            if (game.CanAfford(event.index)) {
+                SetAffordable(event.index, true, changed);
+                entry.readyTime = event.time;
+            }
+            else {
+                Recompute(game, event.index, now, changed);
+            }
+        }
+    }
+
+    bool IsAffordable(int index) const { return entries[index].affordable; }
+
+    // Absolute time (on the caller's clock) when the building becomes
+    // affordable; kNever if current production never gets there
+    double ReadyTime(int index) const { return entries[index].readyTime; }
+
+    // Seconds from `now` until affordable, 0 if affordable already
+    double TimeUntilAffordable(int index, double now) const {
+        const Entry& entry = entries[index];
+        if (entry.affordable) return 0.0;
+        return std::max(0.0, entry.readyTime - now);
+    }
+
+    // Earliest pending event, for sleeping until something happens
+    double NextEventTime() {
+        while (!queue.empty() && queue.top().generation != entries[queue.top().index].generation) queue.pop();
+        return queue.empty() ? kNever : queue.top().time;
+    }
+
+    int64_t Recomputations() const { return recomputations; }
+
+private:
+    struct Entry {
+        double readyTime = kNever;
+        uint64_t generation = 0;        // Invalidates older heap events
+        bool affordable = false;
+    };
+
+    struct Event {
+        double time;
+        int index;
+        uint64_t generation;
+
+        bool operator>(const Event& other) const { return time > other.time; }
+    };
+
+    std::vector<Entry> entries;
+    std::vector<int> usersOf[kResourceCount];   // Buildings whose cost uses each resource
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> queue;
+
+    uint64_t contentVersion = ~0ull;
+    uint64_t ratesVersion = ~0ull;
+    ResourceTable<uint64_t> adjustmentVersions;
+    int64_t recomputations = 0;
+
+    void Rebuild(const GameState& game) {
+        contentVersion = game.contentVersion;
+        entries.assign(game.buildings.size(), Entry());
+        queue = decltype(queue)();
+        for (int r = 0; r < kResourceCount; r++) {
+            usersOf[r].clear();
+            for (int b = 0; b < (int)game.buildings.size(); b++) {
+                if (game.buildings[b].type->cost[r] > 0.0) usersOf[r].push_back(b);
+            }
+        }
+    }
+
+    void RecomputeAll(const GameState& game, double now, std::vector<int>* changed) {
+        ratesVersion = game.ratesVersion;
+
+        // Every entry gets a new event, so start from an empty heap rather
+        // than let stale events pile up
+        queue = decltype(queue)();
+        for (int b = 0; b < (int)entries.size(); b++) Recompute(game, b, now, changed);
+    }
+
+    void Recompute(const GameState& game, int index, double now, std::vector<int>* changed) {
+        recomputations++;
+        Entry& entry = entries[index];
+        entry.generation++;
+
+        double wait = game.TimeUntilAffordable(index);
+        if (wait == 0.0) {
+            entry.readyTime = now;
+            SetAffordable(index, true, changed);
+            return;
+        }
+
+        SetAffordable(index, false, changed);
+        entry.readyTime = now + wait;
+        if (wait < kNever) queue.push(Event{ entry.readyTime, index, entry.generation });
+    }
+
+    void SetAffordable(int index, bool affordable, std::vector<int>* changed) {
+        Entry& entry = entries[index];
+        if (entry.affordable == affordable) return;
+        entry.affordable = affordable;
+        if (changed) changed->push_back(index);
+    }
+};
@@ -0,0 +1,350 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "game.h"
+#include "savegame.h"
+#include "simulation.h"
+
+// Many player sessions on one server, none of them ticked.
+//
+// Each session is a compact record: stockpiles, building counts, cached
+// rates, and the server time it was last evaluated at. Nothing happens to a
+// session between accesses; when one is accessed it is first brought up to
+// the current time with the same closed-form accrual as
+// GameState::AdvanceLinear, which is exact because rates only change on
+// purchases, and purchases only happen during an access.
+//
+// Only `residentCapacity` sessions stay in memory. The least recently used
+// one is paged out to a local file when another needs its slot, and paged
+// back in (rates recomputed from its counts) on its next access.
+//
+// Not thread-safe; shard players across stores to use more cores.
+class SessionStore {
+public:
+    // Sessions start from, and use the content of, `content`. The page file
+    // at `pagePath` is created (or truncated) now and removed with the store.
+    SessionStore(const GameState& content, int residentCapacity, const std::string& pagePath)
+        : residentCapacity(std::max(1, residentCapacity)), pagePath(pagePath) {
+        MirrorGameState(content, scratch, true);
+        initialAmounts = content.amounts;
+        initialRates = content.rates;
+        buildingCount = (int)content.buildings.size();
+        for (const auto& building : content.buildings) initialCounts.push_back(building.count);
+        recordSize = sizeof(SessionPage) + ((buildingCount * sizeof(int32_t) + 7) & ~(size_t)7);
+        pageFile = fopen(pagePath.c_str(), "w+b");
+    }
+
+    ~SessionStore() {
+        if (pageFile) {
+            fclose(pageFile);
+            std::remove(pagePath.c_str());
+        }
+    }
+
+    SessionStore(const SessionStore&) = delete;
+    SessionStore& operator=(const SessionStore&) = delete;
+
+    // False if the page file could not be created
+    bool IsOpen() const { return pageFile != nullptr; }
+
+    // A new game, evaluated as of `now`. Returns the session id; ids are
+    // dense, starting at 0.
+    int CreateSession(double now) {
+        int session = (int)slotOf.size();
+        slotOf.push_back(-1);
+        int slot = AcquireSlot();
+        if (slot < 0) {
+            slotOf.pop_back();
+            return -1;
+        }
+
+        Resident& resident = slots[slot];
+        resident.session = session;
+        resident.evaluatedAt = now;
+        resident.gameTime = 0.0f;
+        resident.amounts = initialAmounts;
+        resident.rates = initialRates;
+        std::copy(initialCounts.begin(), initialCounts.end(), SlotCounts(slot));
+
+        slotOf[session] = slot;
+        PushFront(slot);
+        return session;
+    }
+
+    int SessionCount() const { return (int)slotOf.size(); }
+    int ResidentCount() const { return residentCount; }
+
+    // Bring a session up to `now` and copy it into a GameState with the same
+    // content, e.g. to run arbitrary game code on it. Write it back with
+    // Store() once done; the game must not be advanced in between.
+    bool Load(int session, double now, GameState& game) {
+        int slot = Access(session, now);
+        if (slot < 0) return false;
+
+        const Resident& resident = slots[slot];
+        game.gameTime = resident.gameTime;
+        game.amounts = resident.amounts;
+        const int32_t* counts = SlotCounts(slot);
+        for (int b = 0; b < buildingCount; b++) game.buildings[b].count = counts[b];
+        game.RecalculateProduction();
+        game.MarkAllChanged();
+        return true;
+    }
+
+    // Write back a session loaded with Load(), before accessing any other
+    // session (which could page this one out)
+    void Store(int session, const GameState& game) {
+        int slot = slotOf[session];
+        if (slot < 0) return;
+
+        Resident& resident = slots[slot];
+        resident.gameTime = game.gameTime;
+        resident.amounts = game.amounts;
+        resident.rates = game.rates;
+        int32_t* counts = SlotCounts(slot);
+        for (int b = 0; b < buildingCount; b++) counts[b] = game.buildings[b].count;
+    }
+
+    // One stockpile as of `now`, without copying the session anywhere
+    BigNumber GetAmount(int session, int resource, double now) {
+        int slot = Access(session, now);
+        return slot < 0 ? BigNumber() : slots[slot].amounts[resource];
+    }
+
+    int GetCount(int session, int buildingIndex) {
+        int slot = Touch(session);
+        return slot < 0 ? 0 : SlotCounts(slot)[buildingIndex];
+    }
+
+    // Same as GameState::GatherResource, as of `now`
+    bool GatherResource(int session, ResourceType type, BigNumber amount, double now) {
+        int slot = Access(session, now);
+        if (slot < 0) return false;
+        slots[slot].amounts[type] += amount;
+        return true;
+    }
+
+    // Same as GameState::PurchaseBuilding, as of `now`
+    bool PurchaseBuilding(int session, int buildingIndex, double now) {
+        if (!Load(session, now, scratch)) return false;
+        if (!scratch.PurchaseBuilding(buildingIndex)) return false;
+        Store(session, scratch);
+        return true;
+    }
+
+    // Statistics
+    uint64_t PageIns() const { return pageIns; }
+    uint64_t PageOuts() const { return pageOuts; }
+    uint64_t PageFailures() const { return pageFailures; }
+    size_t RecordBytes() const { return recordSize; }
+
+    // Heap and inline memory held for sessions (not the content tables)
+    size_t MemoryBytes() const {
+        return slots.capacity() * sizeof(Resident) + slotCounts.capacity() * sizeof(int32_t)
+            + slotOf.capacity() * sizeof(int32_t) + freeSlots.capacity() * sizeof(int32_t);
+    }
+
+private:
+    // One resident session; counts live in slotCounts at the same index
+    struct Resident {
+        int32_t session;
+        int32_t prev;                   // LRU neighbours, -1 at the ends
+        int32_t next;
+        float gameTime;
+        double evaluatedAt;
+        ResourceAmounts amounts;
+        ResourceValues rates;
+    };
+
+    // Paged-out session, followed by int32_t counts padded to 8 bytes. Same
+    // conventions as the save format; the file is scratch space, so it has
+    // no header or checksum.
+    struct SessionPage {
+        double evaluatedAt;
+        float gameTime;
+        uint32_t reserved;
+        SaveResource amounts[kResourceCount];
+    };
+    static_assert(sizeof(SessionPage) == 80, "SessionPage layout is part of the page file");
+
+    int residentCapacity;
+    int buildingCount = 0;
+    size_t recordSize = 0;
+    std::string pagePath;
+    FILE* pageFile = nullptr;
+
+    std::vector<int32_t> slotOf;        // Per session: resident slot, or -1 if paged out
+    std::vector<Resident> slots;
+    std::vector<int32_t> slotCounts;    // buildingCount per slot
+    std::vector<int32_t> freeSlots;
+    int residentCount = 0;
+    int head = -1;                      // Most recently used
+    int tail = -1;                      // Least recently used
+
+    uint64_t pageIns = 0;
+    uint64_t pageOuts = 0;
+    uint64_t pageFailures = 0;
+
+    ResourceAmounts initialAmounts;     // Starting state for new sessions
+    ResourceValues initialRates;
+    std::vector<int32_t> initialCounts;
+    GameState scratch;                  // For running game code on a session
+    std::vector<uint64_t> pageBuffer;   // One record, as uint64_t for alignment
+
+    int32_t* SlotCounts(int slot) { return slotCounts.data() + (size_t)slot * buildingCount; }
+    const int32_t* SlotCounts(int slot) const { return slotCounts.data() + (size_t)slot * buildingCount; }
+
+    // Make a session resident and most recently used, then accrue it to `now`
+    int Access(int session, double now) {
+        int slot = Touch(session);
+        if (slot >= 0) Accrue(slots[slot], now);
+        return slot;
+    }
+
+    // Make a session resident and most recently used, without moving time
+    int Touch(int session) {
+        if (session < 0 || session >= (int)slotOf.size()) return -1;
+
+        int slot = slotOf[session];
+        if (slot < 0) {
+            slot = PageIn(session);
+            if (slot < 0) return -1;
+        }
+        else {
+            Unlink(slot);
+        }
+        PushFront(slot);
+        return slot;
+    }
+
+    // Identical arithmetic to GameState::AdvanceLinear, so a lazily
+    // evaluated session matches one that was advanced eagerly
+    static void Accrue(Resident& resident, double now) {
+        double seconds = now - resident.evaluatedAt;
+        if (seconds <= 0.0) return;
+
+        resident.gameTime += (float)seconds;
+        for (int r = 0; r < kResourceCount; r++) {
+            resident.amounts[r] += resident.rates[r] * seconds;
+            if (resident.amounts[r].IsNegative()) resident.amounts[r] = BigNumber();
+        }
+        resident.evaluatedAt = now;
+    }
+
+    // A free slot, evicting the least recently used session if needed
+    int AcquireSlot() {
+        if (!freeSlots.empty()) {
+            int slot = freeSlots.back();
+            freeSlots.pop_back();
+            residentCount++;
+            return slot;
+        }
+        if ((int)slots.size() < residentCapacity) {
+            slots.emplace_back();
+            slotCounts.resize(slots.size() * buildingCount);
+            residentCount++;
+            return (int)slots.size() - 1;
+        }
+
+        int slot = tail;
+        if (!PageOut(slot)) return -1;
+        return slot;
+    }
+
+    bool PageOut(int slot) {
+        const Resident& resident = slots[slot];
+        SessionPage* page = PageBuffer();
+        page->evaluatedAt = resident.evaluatedAt;
+        page->gameTime = resident.gameTime;
+        page->reserved = 0;
+        for (int r = 0; r < kResourceCount; r++) {
+            page->amounts[r].mantissa = resident.amounts[r].mantissa;
+            page->amounts[r].exponent = resident.amounts[r].exponent;
+        }
+        memcpy(page + 1, SlotCounts(slot), buildingCount * sizeof(int32_t));
+
+        if (!SeekPage(resident.session) || fwrite(page, 1, recordSize, pageFile) != recordSize) {
+            pageFailures++;
+            return false;
+        }
+
+        pageOuts++;
+        slotOf[resident.session] = -1;
+        Unlink(slot);
+        return true;
+    }
+
+    int PageIn(int session) {
+        // Evicts first, which uses the page buffer too
+        int slot = AcquireSlot();
+        if (slot < 0) return -1;
+
+        SessionPage* page = PageBuffer();
+        if (!SeekPage(session) || fread(page, 1, recordSize, pageFile) != recordSize) {
+            pageFailures++;
+            ReleaseSlot(slot);
+            return -1;
+        }
+
+        Resident& resident = slots[slot];
+        resident.session = session;
+        resident.evaluatedAt = page->evaluatedAt;
+        resident.gameTime = page->gameTime;
+        for (int r = 0; r < kResourceCount; r++) {
+            resident.amounts[r].mantissa = page->amounts[r].mantissa;
+            resident.amounts[r].exponent = page->amounts[r].exponent;
+        }
+        int32_t* counts = SlotCounts(slot);
+        memcpy(counts, page + 1, buildingCount * sizeof(int32_t));
+
+        // Rates depend only on counts; the graph only redoes buildings whose
+        // count differs from the last session it evaluated
+        scratch.productionGraph.SetCounts(counts);
+        for (int r = 0; r < kResourceCount; r++) resident.rates[r] = scratch.productionGraph.Rates()[r];
+
+        pageIns++;
+        slotOf[session] = slot;
+        return slot;
+    }
+
+    void ReleaseSlot(int slot) {
+        freeSlots.push_back(slot);
+        residentCount--;
+    }
+
+    SessionPage* PageBuffer() {
+        if (pageBuffer.size() * sizeof(uint64_t) < recordSize) pageBuffer.resize(recordSize / sizeof(uint64_t));
+        return (SessionPage*)pageBuffer.data();
+    }
+
+    bool SeekPage(int session) {
+        if (!pageFile) return false;
+        int64_t offset = (int64_t)session * (int64_t)recordSize;
+#ifdef _WIN32
+        return _fseeki64(pageFile, offset, SEEK_SET) == 0;
+#else
+        return fseeko(pageFile, (off_t)offset, SEEK_SET) == 0;
+#endif
+    }
+
+    void PushFront(int slot) {
+        slots[slot].prev = -1;
+        slots[slot].next = head;
+        if (head >= 0) slots[head].prev = slot;
+        head = slot;
+        if (tail < 0) tail = slot;
+    }
+
+    void Unlink(int slot) {
+        Resident& resident = slots[slot];
+        if (resident.prev >= 0) slots[resident.prev].next = resident.next;
+        else head = resident.next;
+        if (resident.next >= 0) slots[resident.next].prev = resident.prev;
+        else tail = resident.prev;
+        resident.prev = resident.next = -1;
+    }
+};
@@ -0,0 +1,368 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "alloccount.h"
+#include "automation.h"
+#include "game.h"
+#include "commandlog.h"
+#include "profiler.h"
+#include "spscqueue.h"
+
+// Copy a GameState into another that mirrors it (e.g. a render snapshot).
+// Stockpiles, rates, counts and change counters are copied every time and
+// never allocate; names and building types are only copied when the
+// source's contentVersion moved, and the mirror's buildings point into its
+// own type table.
+inline void MirrorGameState(const GameState& source, GameState& mirror, bool copyContent = false) {
+    if (copyContent || mirror.contentVersion != source.contentVersion || mirror.buildings.size() != source.buildings.size()) {
+        mirror.resourceNames = source.resourceNames;
+        mirror.buildingTypes = source.buildingTypes;
+        mirror.productionGraph = source.productionGraph;
+        mirror.buildings.clear();
+        for (size_t b = 0; b < source.buildings.size(); b++) {
+            mirror.buildings.push_back(Building(&mirror.buildingTypes[b], 0));
+        }
+    }
+
+    mirror.amounts = source.amounts;
+    mirror.rates = source.rates;
+    mirror.baseRates = source.baseRates;
+    mirror.gameTime = source.gameTime;
+    for (size_t b = 0; b < source.buildings.size(); b++) {
+        mirror.buildings[b].count = source.buildings[b].count;
+        mirror.buildings[b].version = source.buildings[b].version;
+    }
+    mirror.amountVersions = source.amountVersions;
+    mirror.adjustmentVersions = source.adjustmentVersions;
+    mirror.ratesVersion = source.ratesVersion;
+    mirror.contentVersion = source.contentVersion;
+}
+
+// Lock-free triple buffer: one writer publishes complete values, one reader
+// picks up the newest. Neither side ever waits for the other; the reader
+// may skip values, and sees the same value again if nothing new arrived.
+template <typename T>
+class TripleBuffer {
+public:
+    T buffers[3];
+
+    // Writer: the value to fill in, then Publish() it
+    T& Back() { return buffers[back]; }
+
+    void Publish() {
+        back = middle.exchange(back | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Reader: switch to the newest published value, if there is one.
+    // Front() stays valid and unchanged until the next Acquire().
+    bool Acquire() {
+        if (!(middle.load(std::memory_order_acquire) & kFresh)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    T& Front() { return buffers[front]; }
+
+private:
+    static constexpr uint8_t kIndexMask = 3;
+    static constexpr uint8_t kFresh = 4;
+
+    std::atomic<uint8_t> middle{ 1 };
+    uint8_t back = 0;       // Writer only
+    uint8_t front = 2;      // Reader only
+};
+
+// Timing of the simulation thread, published with every snapshot
+struct SimulationStats {
+    double targetHz = 0.0;
+    double measuredHz = 0.0;            // Ticks per second over the last second
+    int64_t ticks = 0;
+    double averageTickMicros = 0.0;     // Cost of one tick (commands + Update)
+    double maxTickMicros = 0.0;
+    double averageWakeLateMicros = 0.0; // How late the thread woke for its next tick
+    double maxWakeLateMicros = 0.0;
+    int64_t catchUpTicks = 0;           // Ticks run back to back after a late wake
+    double droppedSeconds = 0.0;        // Time given up when too far behind
+    int64_t commandsApplied = 0;        // Input commands taken from the queue
+    int64_t commandsRejected = 0;       // Input queue was full
+    int64_t resultsDropped = 0;         // Outcomes lost: result queue was full
+    int64_t gatherBatches = 0;          // Coalesced gathers applied
+    int64_t gathersCoalesced = 0;       // Gather commands merged into another
+    int64_t maxQueueDepth = 0;          // Most commands waiting at the start of a tick
+    double averageQueueDepth = 0.0;
+    int64_t automationPurchases = 0;    // Bought by auto-buy rules
+    int64_t automationEvaluations = 0;  // Rules re-evaluated
+    int64_t allocatingTicks = 0;        // Game updates that hit the heap (counting builds only)
+};
+
+// What the renderer reads: the game as of the end of a tick
+struct SimulationSnapshot {
+    GameState game;
+    double time = 0.0;                  // Simulated seconds since Start()
+    SimulationStats stats;
+};
+
+// Runs a GameState on its own thread at a fixed timestep.
+//
+// Every tick applies queued input commands, then advances the game by
+// exactly 1/hz seconds, so the simulation no longer depends on the frame
+// rate and every tick uses the same float delta. After the ticks due at
+// each wake-up, the state is published to a triple-buffered snapshot.
+//
+// Runs of gathers in the queue (auto-clickers send thousands per second)
+// are merged into one gather per resource, applied and logged once with the
+// total amount and click count. Any other command ends the run, so gathers
+// and purchases still apply in the order they were clicked.
+//
+// Threads:
+//  - Submit() and PollResult() are for one input thread (the UI); commands
+//    and their outcomes travel through lock-free SPSC queues.
+//  - AcquireSnapshot() is for one reader thread (the renderer, usually the
+//    same UI thread). It never blocks the simulation.
+//  - Invoke() runs rare control work (content reloads) on the simulation
+//    thread; it takes a lock, but the tick only checks an atomic flag.
+// While running, the GameState belongs to the simulation thread.
+class SimulationThread {
+public:
+    static constexpr int kMaxCatchUpTicks = 8;      // Past this, drop time instead of spiralling
+
+    SimulationThread(GameState& game, double hz = 60.0, CommandLog* log = nullptr, size_t queueCapacity = 1024)
+        : game(game), log(log), hz(hz), deltaTime((float)(1.0 / hz)), inputs(queueCapacity), results(queueCapacity) {
+        for (auto& snapshot : snapshots.buffers) {
+            MirrorGameState(game, snapshot.game, true);
+            snapshot.stats.targetHz = hz;
+        }
+    }
+
+    ~SimulationThread() { Stop(); }
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void Start() {
+        if (running.exchange(true)) return;
+        thread = std::thread([this]() { Run(); });
+    }
+
+    // Stops after the current tick; the GameState is the caller's again
+    void Stop() {
+        if (!running.exchange(false)) return;
+        thread.join();
+    }
+
+    // Queue a player command for the next tick. Fails only if the queue is full.
+    bool Submit(const Command& command) {
+        if (inputs.Push(command)) return true;
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Outcomes of submitted commands, in order (Command::succeeded is set).
+    // Outcomes that find the queue full are dropped and counted in
+    // SimulationStats::resultsDropped; the commands still apply.
+    bool PollResult(Command& command) { return results.Pop(command); }
+
+    // Newest published state. Valid until the next call.
+    SimulationSnapshot& AcquireSnapshot() {
+        snapshots.Acquire();
+        return snapshots.Front();
+    }
+
+    // Run a function on the simulation thread before its next tick, or
+    // right away if the thread is not running
+    void Invoke(std::function<void(GameState&)> task) {
+        if (!running.load()) {
+            task(game);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(taskMutex);
+        tasks.push_back(std::move(task));
+        hasTasks.store(true, std::memory_order_release);
+    }
+
+    // Auto-buy rules, evaluated after every tick on the simulation thread.
+    // Their purchases are logged and reported through PollResult() like the
+    // player's. Set before Start().
+    void SetAutomation(AutomationEngine* engine) { automation = engine; }
+
+    double Hz() const { return hz; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    GameState& game;
+    CommandLog* log;
+    AutomationEngine* automation = nullptr;
+    double hz;
+    float deltaTime;
+
+    SpscQueue<Command> inputs;
+    SpscQueue<Command> results;
+    TripleBuffer<SimulationSnapshot> snapshots;
+
+    std::atomic<bool> running{ false };
+    std::thread thread;
+
+    std::mutex taskMutex;
+    std::vector<std::function<void(GameState&)>> tasks;
+    std::atomic<bool> hasTasks{ false };
+
+    std::atomic<int64_t> rejected{ 0 };
+    SimulationStats stats;
+    int64_t ticks = 0;
+    int64_t queueDepthTotal = 0;
+
+    // Gathers waiting to be applied as one, per resource
+    double gatherAmounts[kResourceCount] = {};
+    int32_t gatherClicks[kResourceCount] = {};
+    int64_t gatherCommands[kResourceCount] = {};
+
+    void Run() {
+        const auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz));
+        auto next = Clock::now();
+        auto rateWindowStart = next;
+        int64_t rateWindowTicks = 0;
+        double tickMicrosTotal = 0.0;
+        double lateMicrosTotal = 0.0;
+        int64_t wakes = 0;
+
+        stats.targetHz = hz;
+        Profiler::SetThreadName("Simulation");
+        while (running.load(std::memory_order_acquire)) {
+            auto now = Clock::now();
+            double lateMicros = std::chrono::duration<double, std::micro>(now - next).count();
+            if (lateMicros > 0.0) {
+                wakes++;
+                lateMicrosTotal += lateMicros;
+                stats.maxWakeLateMicros = std::max(stats.maxWakeLateMicros, lateMicros);
+                stats.averageWakeLateMicros = lateMicrosTotal / wakes;
+            }
+
+            int ticksThisWake = 0;
+            while (next <= now && ticksThisWake < kMaxCatchUpTicks) {
+                auto tickStart = Clock::now();
+                Tick();
+                double tickMicros = std::chrono::duration<double, std::micro>(Clock::now() - tickStart).count();
+                tickMicrosTotal += tickMicros;
+                stats.maxTickMicros = std::max(stats.maxTickMicros, tickMicros);
+
+                next += step;
+                ticksThisWake++;
+                rateWindowTicks++;
+            }
+            if (ticksThisWake > 1) stats.catchUpTicks += ticksThisWake - 1;
+
+            // Too far behind (e.g. the machine slept): give the time up
+            if (next <= now) {
+                stats.droppedSeconds += std::chrono::duration<double>(now - next).count();
+                next = now + step;
+            }
+
+            double windowSeconds = std::chrono::duration<double>(now - rateWindowStart).count();
+            if (windowSeconds >= 1.0) {
+                stats.measuredHz = rateWindowTicks / windowSeconds;
+                rateWindowStart = now;
+                rateWindowTicks = 0;
+            }
+
+            if (ticksThisWake > 0) {
+                stats.ticks = ticks;
+                stats.averageTickMicros = tickMicrosTotal / ticks;
+                stats.commandsRejected = rejected.load(std::memory_order_relaxed);
+                Publish();
+            }
+
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    void Tick() {
+        PROFILE_ZONE("SimulationThread::Tick");
+        if (hasTasks.load(std::memory_order_acquire)) RunTasks();
+
+        int64_t depth = (int64_t)inputs.SizeApprox();
+        queueDepthTotal += depth;
+        stats.maxQueueDepth = std::max(stats.maxQueueDepth, depth);
+        stats.averageQueueDepth = (double)queueDepthTotal / (ticks + 1);
+
+        // Only what was queued when the tick began; a producer that keeps
+        // up with the drain must not hold back the fixed-rate tick
+        Command command;
+        for (int64_t i = 0; i < depth && inputs.Pop(command); i++) {
+            stats.commandsApplied++;
+            if (command.type == CommandType::Gather && command.index >= 0 && command.index < kResourceCount) {
+                gatherAmounts[command.index] += command.value;
+                gatherClicks[command.index] += command.count;
+                gatherCommands[command.index]++;
+                continue;
+            }
+            ApplyGathers();
+            Apply(command);
+        }
+        ApplyGathers();
+
+        // Advancing the game must never allocate; the log records outside
+        // the check since its buffer grows now and then
+        Command tick = Command::Tick(deltaTime);
+        ThreadAllocationScope allocations;
+        ApplyCommand(game, tick);
+        if (allocations.Count() > 0) stats.allocatingTicks++;
+        if (log) log->Record(tick);
+        ticks++;
+
+        if (automation) {
+            stats.automationPurchases += automation->Update(game, ticks / hz, [this](int index) {
+                Command purchase = Command::Purchase(index);
+                Apply(purchase);
+                return purchase.succeeded != 0;
+                });
+            stats.automationEvaluations = automation->Evaluations();
+        }
+    }
+
+    void Apply(Command& command) {
+        command.succeeded = (log ? log->Execute(game, command) : ApplyCommand(game, command)) ? 1 : 0;
+
+        // The command has been applied either way; only its report is lost
+        if (!results.Push(command)) stats.resultsDropped++;
+    }
+
+    // One gather per resource for the run collected so far
+    void ApplyGathers() {
+        for (int r = 0; r < kResourceCount; r++) {
+            if (gatherCommands[r] == 0) continue;
+            Command batch = Command::Gather((ResourceType)r, gatherAmounts[r], gatherClicks[r]);
+            Apply(batch);
+            stats.gatherBatches++;
+            stats.gathersCoalesced += gatherCommands[r] - 1;
+            gatherAmounts[r] = 0.0;
+            gatherClicks[r] = 0;
+            gatherCommands[r] = 0;
+        }
+    }
+
+    void RunTasks() {
+        std::vector<std::function<void(GameState&)>> pending;
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+            pending.swap(tasks);
+            hasTasks.store(false, std::memory_order_release);
+        }
+        for (auto& task : pending) task(game);
+    }
+
+    void Publish() {
+        PROFILE_ZONE("SimulationThread::Publish");
+        SimulationSnapshot& snapshot = snapshots.Back();
+        MirrorGameState(game, snapshot.game);
+        snapshot.time = ticks / hz;
+        snapshot.stats = stats;
+        snapshots.Publish();
+    }
+};
@@ -0,0 +1,378 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+#include "savegame.h"
+
+// Delta-compressed save snapshots, for frequent autosave and sync.
+//
+// Between autosaves only a few building counts change, so most snapshots
+// are written as a delta against the last full snapshot (the base): the
+// stockpiles that changed, stored whole, and the changed counts as varint
+// (index gap, count difference) pairs. Every delta refers to its base
+// directly, never to another delta, so any snapshot restores from at most
+// two files. A delta keeps its base's building names; a snapshot taken
+// after the building list changed is written in full.
+//
+// Deltas grow as play moves away from the base. Once one would be larger
+// than compactRatio of a full snapshot (or than kSmallDeltaBytes, if that
+// is more, so small content whose delta header alone is a large share of a
+// full save still gets deltas), or maxDeltas have been written since the
+// base, the next snapshot is written in full instead and becomes the new
+// base (compaction); files older than the last retainBases bases are then
+// removed. A delta is never written when it is no smaller than the full
+// snapshot.
+//
+// A SnapshotStore keeps its files in one directory, written once each with
+// WriteFileAtomic and never modified, so the directory can stand in for (or
+// be mirrored to) object storage:
+//
+//   <sequence>.full     a save in the format of savegame.h
+//   <sequence>.delta    SnapshotDeltaHeader + payload:
+//                         uint8 mask of changed resources
+//                         SaveResource for each bit set
+//                         varint number of changed counts
+//                         per change: varint index gap, zigzag varint difference
+//                         zero padding to 8 bytes
+//
+// Sequences are 16 hex digits, so names sort in order.
+const uint32_t kSnapshotDeltaMagic = 0x44434e49;   // "INCD"
+const uint32_t kSnapshotDeltaVersion = 1;
+
+struct SnapshotDeltaHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t buildingCount;
+    uint64_t sequence;
+    uint64_t baseSequence;
+    uint64_t baseChecksum;      // Payload checksum of the base, so a delta never applies to the wrong one
+    double gameTime;
+    uint64_t payloadSize;
+    uint64_t checksum;
+};
+static_assert(sizeof(SnapshotDeltaHeader) == 64, "SnapshotDeltaHeader layout is part of the file format");
+
+namespace snapshot_detail {
+
+inline void AppendVarint(std::vector<unsigned char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+inline bool ReadVarint(const unsigned char*& p, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end) return false;
+        unsigned char byte = *p++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+inline uint64_t ZigZag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+inline int64_t UnZigZag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+inline int32_t CountAt(const std::vector<int32_t>& counts, size_t index) {
+    return index < counts.size() ? counts[index] : 0;
+}
+
+} // namespace snapshot_detail
+
+// Encode `save` as a delta against `base`
+inline std::vector<unsigned char> EncodeSnapshotDelta(const SaveData& base, uint64_t baseSequence, uint64_t baseChecksum,
+    const SaveData& save, uint64_t sequence) {
+    using namespace snapshot_detail;
+    std::vector<unsigned char> buffer(sizeof(SnapshotDeltaHeader), 0);
+
+    // Stockpiles
+    size_t maskOffset = buffer.size();
+    buffer.push_back(0);
+    for (int r = 0; r < kResourceCount; r++) {
+        if (save.amounts[r].mantissa == base.amounts[r].mantissa && save.amounts[r].exponent == base.amounts[r].exponent) continue;
+        buffer[maskOffset] |= (unsigned char)(1u << r);
+        SaveResource resource = { save.amounts[r].mantissa, save.amounts[r].exponent };
+        const unsigned char* bytes = (const unsigned char*)&resource;
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(resource));
+    }
+
+    // Building counts
+    size_t changes = 0;
+    for (size_t b = 0; b < save.counts.size(); b++) changes += save.counts[b] != CountAt(base.counts, b);
+    AppendVarint(buffer, changes);
+    size_t previous = 0;
+    for (size_t b = 0; b < save.counts.size(); b++) {
+        int32_t baseCount = CountAt(base.counts, b);
+        if (save.counts[b] == baseCount) continue;
+        AppendVarint(buffer, b - previous);
+        AppendVarint(buffer, ZigZag((int64_t)save.counts[b] - baseCount));
+        previous = b;
+    }
+    buffer.resize((buffer.size() + 7) & ~(size_t)7, 0);
+
+    SnapshotDeltaHeader header = {};
+    header.magic = kSnapshotDeltaMagic;
+    header.version = kSnapshotDeltaVersion;
+    header.headerSize = sizeof(SnapshotDeltaHeader);
+    header.buildingCount = (uint32_t)save.counts.size();
+    header.sequence = sequence;
+    header.baseSequence = baseSequence;
+    header.baseChecksum = baseChecksum;
+    header.gameTime = save.gameTime;
+    header.payloadSize = buffer.size() - sizeof(SnapshotDeltaHeader);
+    header.checksum = SaveChecksum(buffer.data() + sizeof(SnapshotDeltaHeader), header.payloadSize);
+    memcpy(buffer.data(), &header, sizeof(header));
+    return buffer;
+}
+
+// Check magic, version, sizes and checksum, and copy out the header
+inline bool ValidateSnapshotDelta(const unsigned char* bytes, size_t size, SnapshotDeltaHeader& header) {
+    if (size < sizeof(SnapshotDeltaHeader)) return false;
+    memcpy(&header, bytes, sizeof(header));
+    if (header.magic != kSnapshotDeltaMagic || header.version != kSnapshotDeltaVersion) return false;
+    if (header.headerSize != sizeof(SnapshotDeltaHeader) || header.payloadSize % 8 != 0) return false;
+    if (size < sizeof(SnapshotDeltaHeader) + header.payloadSize) return false;
+    return SaveChecksum(bytes + sizeof(SnapshotDeltaHeader), header.payloadSize) == header.checksum;
+}
+
+// Reconstruct a snapshot from its base and a validated delta. Fails on a
+// malformed payload or values no save can hold (see LoadedSave::Validate).
+inline bool ApplySnapshotDelta(const SaveData& base, const unsigned char* bytes, size_t size, SaveData& save) {
+    using namespace snapshot_detail;
+    SnapshotDeltaHeader header;
+    if (!ValidateSnapshotDelta(bytes, size, header)) return false;
+    const unsigned char* p = bytes + sizeof(SnapshotDeltaHeader);
+    const unsigned char* end = p + header.payloadSize;
+
+    if (!std::isfinite(header.gameTime)) return false;
+    save.gameTime = header.gameTime;
+    save.amounts = base.amounts;
+    if (p == end) return false;
+    unsigned char mask = *p++;
+    for (int r = 0; r < kResourceCount; r++) {
+        if (!(mask & (1u << r))) continue;
+        if (end - p < (ptrdiff_t)sizeof(SaveResource)) return false;
+        SaveResource resource;
+        memcpy(&resource, p, sizeof(resource));
+        p += sizeof(resource);
+        if (!std::isfinite(resource.mantissa) || resource.mantissa < 0.0) return false;
+        save.amounts[r].mantissa = resource.mantissa;
+        save.amounts[r].exponent = resource.exponent;
+    }
+
+    save.counts.resize(header.buildingCount);
+    for (size_t b = 0; b < save.counts.size(); b++) save.counts[b] = CountAt(base.counts, b);
+    if (base.buildingNames.size() == save.counts.size()) save.buildingNames = base.buildingNames;
+    else save.buildingNames.clear();
+
+    uint64_t changes;
+    if (!ReadVarint(p, end, changes)) return false;
+    uint64_t index = 0;
+    for (uint64_t i = 0; i < changes; i++) {
+        uint64_t gap, difference;
+        if (!ReadVarint(p, end, gap) || !ReadVarint(p, end, difference)) return false;
+        index += gap;
+        if (index >= save.counts.size()) return false;
+        // Both counts are in [0, INT32_MAX], and so is their difference's size
+        const int64_t maxCount = std::numeric_limits<int32_t>::max();
+        int64_t change = UnZigZag(difference);
+        if (change > maxCount || change < -maxCount) return false;
+        int64_t count = save.counts[index] + change;
+        if (count < 0 || count > maxCount) return false;
+        save.counts[index] = (int32_t)count;
+    }
+    return true;
+}
+
+// A directory of full and delta snapshots. Use from one thread (the
+// autosave worker); Restore only reads files and may run on another thread
+// while nothing is being written.
+class SnapshotStore {
+public:
+    static constexpr size_t kSmallDeltaBytes = 1024;
+
+    explicit SnapshotStore(const std::string& directory, double compactRatio = 0.25, int maxDeltas = 720, int retainBases = 2)
+        : directory(directory), compactRatio(compactRatio), maxDeltas(maxDeltas), retainBases(std::max(1, retainBases)) {
+    }
+
+    // Create the directory if needed and continue from what it holds
+    bool Open() {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) return false;
+
+        hasBase = false;
+        deltasSinceBase = 0;
+        std::vector<uint64_t> bases, deltas;
+        List(bases, deltas);
+        if (!bases.empty() || !deltas.empty()) {
+            uint64_t last = std::max(bases.empty() ? 0 : bases.back(), deltas.empty() ? 0 : deltas.back());
+            nextSequence = last + 1;
+        }
+
+        // New deltas continue against the newest readable base
+        for (auto it = bases.rbegin(); it != bases.rend(); ++it) {
+            LoadedSave loaded;
+            if (!loaded.Open(FilePath(*it, true))) continue;
+            base = loaded.ToSaveData();
+            baseSequence = *it;
+            baseChecksum = loaded.Checksum();
+            baseBytes = loaded.Bytes();
+            hasBase = true;
+            for (uint64_t delta : deltas) deltasSinceBase += delta > baseSequence;
+            break;
+        }
+        return true;
+    }
+
+    // Write the next snapshot, as a delta when worthwhile
+    bool Write(const SaveData& save) {
+        uint64_t sequence = nextSequence++;
+        if (hasBase && deltasSinceBase < maxDeltas && save.buildingNames == base.buildingNames) {
+            std::vector<unsigned char> delta = EncodeSnapshotDelta(base, baseSequence, baseChecksum, save, sequence);
+            size_t limit = std::max((size_t)(compactRatio * baseBytes), kSmallDeltaBytes);
+            if (delta.size() <= limit && delta.size() < EncodedSaveSize(save)) {
+                if (!WriteFileAtomic(FilePath(sequence, false), delta.data(), delta.size())) return false;
+                bytesWritten += delta.size();
+                deltasSinceBase++;
+                deltaWrites++;
+                return true;
+            }
+        }
+
+        std::vector<unsigned char> full = EncodeSave(save);
+        if (!WriteFileAtomic(FilePath(sequence, true), full.data(), full.size())) return false;
+        bytesWritten += full.size();
+        if (hasBase) compactions++;
+        fullWrites++;
+
+        SaveHeader header;
+        memcpy(&header, full.data(), sizeof(header));
+        base = save;
+        baseSequence = sequence;
+        baseChecksum = header.checksum;
+        baseBytes = full.size();
+        hasBase = true;
+        deltasSinceBase = 0;
+        RemoveOldFiles();
+        return true;
+    }
+
+    // Reconstruct one retained snapshot
+    bool Restore(uint64_t sequence, SaveData& save) const {
+        LoadedSave loaded;
+        if (loaded.Open(FilePath(sequence, true))) {
+            save = loaded.ToSaveData();
+            return true;
+        }
+
+        MappedFile file;
+        SnapshotDeltaHeader header;
+        if (!file.Open(FilePath(sequence, false)) || !ValidateSnapshotDelta(file.Data(), file.Size(), header)) return false;
+        if (!loaded.Open(FilePath(header.baseSequence, true)) || loaded.Checksum() != header.baseChecksum) return false;
+        return ApplySnapshotDelta(loaded.ToSaveData(), file.Data(), file.Size(), save);
+    }
+
+    // The newest snapshot that restores, skipping damaged ones
+    bool RestoreLatest(SaveData& save) const {
+        // Usually the one this store wrote last, without listing the directory
+        if (LastSequence() > 0 && Restore(LastSequence(), save)) return true;
+
+        std::vector<uint64_t> sequences = Sequences();
+        for (auto it = sequences.rbegin(); it != sequences.rend(); ++it) {
+            if (Restore(*it, save)) return true;
+        }
+        return false;
+    }
+
+    // Retained snapshots, oldest first
+    std::vector<uint64_t> Sequences() const {
+        std::vector<uint64_t> bases, deltas;
+        List(bases, deltas);
+        std::vector<uint64_t> all;
+        std::merge(bases.begin(), bases.end(), deltas.begin(), deltas.end(), std::back_inserter(all));
+        return all;
+    }
+
+    // Sequence of the last snapshot written (or attempted)
+    uint64_t LastSequence() const { return nextSequence - 1; }
+
+    uint64_t BytesWritten() const { return bytesWritten; }
+    uint64_t FullWrites() const { return fullWrites; }
+    uint64_t DeltaWrites() const { return deltaWrites; }
+    uint64_t Compactions() const { return compactions; }
+    uint64_t FilesRemoved() const { return filesRemoved; }
+
+private:
+    std::string directory;
+    double compactRatio;
+    int maxDeltas;
+    int retainBases;
+
+    SaveData base;
+    bool hasBase = false;
+    uint64_t baseSequence = 0;
+    uint64_t baseChecksum = 0;
+    size_t baseBytes = 0;
+    int deltasSinceBase = 0;
+    uint64_t nextSequence = 1;
+
+    uint64_t bytesWritten = 0;
+    uint64_t fullWrites = 0;
+    uint64_t deltaWrites = 0;
+    uint64_t compactions = 0;
+    uint64_t filesRemoved = 0;
+
+    static size_t EncodedSaveSize(const SaveData& save) {
+        bool named = save.buildingNames.size() == save.counts.size();
+        return sizeof(SaveHeader) + SavePayloadSize(save.counts.size(), named ? kSaveVersion : kSaveVersionPositional);
+    }
+
+    std::string FilePath(uint64_t sequence, bool full) const {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.%s", (unsigned long long)sequence, full ? "full" : "delta");
+        return (std::filesystem::path(directory) / name).string();
+    }
+
+    // Sequences of the files present, each list sorted
+    void List(std::vector<uint64_t>& bases, std::vector<uint64_t>& deltas) const {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            std::string name = entry.path().filename().string();
+            std::string extension = entry.path().extension().string();
+            if (name.size() < 17 || name[16] != '.') continue;
+            char* end = nullptr;
+            uint64_t sequence = strtoull(name.c_str(), &end, 16);
+            if (end != name.c_str() + 16) continue;
+            if (extension == ".full") bases.push_back(sequence);
+            else if (extension == ".delta") deltas.push_back(sequence);
+        }
+        std::sort(bases.begin(), bases.end());
+        std::sort(deltas.begin(), deltas.end());
+    }
+
+    // Drop everything older than the oldest retained base
+    void RemoveOldFiles() {
+        std::vector<uint64_t> bases, deltas;
+        List(bases, deltas);
+        if ((int)bases.size() <= retainBases) return;
+        uint64_t cutoff = bases[bases.size() - retainBases];
+        for (uint64_t sequence : bases) {
+            if (sequence < cutoff && std::remove(FilePath(sequence, true).c_str()) == 0) filesRemoved++;
+        }
+        for (uint64_t sequence : deltas) {
+            if (sequence < cutoff && std::remove(FilePath(sequence, false).c_str()) == 0) filesRemoved++;
+        }
+    }
+};
@@ -0,0 +1,407 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "game.h"
+#include "threadpool.h"
+
+// What the build-order solver is trying to reach as early as possible
+struct SolverGoal {
+    enum class Kind {
+        BuildingCount,      // Own at least `count` of building `buildingIndex`
+        ResourceAmount      // Hold at least `amount` of `resource`
+    };
+
+    Kind kind = Kind::BuildingCount;
+    int buildingIndex = 0;
+    int count = 1;
+    ResourceType resource = ResourceType::Food;
+    BigNumber amount;
+
+    static SolverGoal Building(int buildingIndex, int count = 1) {
+        SolverGoal goal;
+        goal.kind = Kind::BuildingCount;
+        goal.buildingIndex = buildingIndex;
+        goal.count = count;
+        return goal;
+    }
+
+    static SolverGoal Resource(ResourceType resource, BigNumber amount) {
+        SolverGoal goal;
+        goal.kind = Kind::ResourceAmount;
+        goal.resource = resource;
+        goal.amount = amount;
+        return goal;
+    }
+};
+
+struct SolverResult {
+    bool found = false;
+    double time = 0.0;                  // Seconds from the start state to the goal
+    std::vector<int> purchases;         // Building indices, in purchase order
+
+    // Search statistics
+    int64_t nodesExpanded = 0;
+    int64_t prunedByBound = 0;
+    int64_t prunedByDominance = 0;
+    int64_t steals = 0;
+    double wallSeconds = 0.0;
+
+    double NodesPerSecond() const { return wallSeconds > 0.0 ? nodesExpanded / wallSeconds : 0.0; }
+};
+
+// Finds the purchase order that reaches a goal soonest, starting from a
+// GameState, for balance tuning.
+//
+// Depth-first branch-and-bound over "buy building b next" decisions. Time
+// between purchases is advanced analytically (no frames), exactly like
+// GameState::Advance. Rates come from the game's ModifierGraph, so they match
+// what GameState computes for the same counts exactly. Nodes are pruned when:
+//  - an optimistic finish time (every remaining purchase bought at once, for
+//    free, split in the best possible way between production and bonuses)
+//    cannot beat the best solution so far, or
+//  - another node with the same building counts reached an equal or better
+//    stockpile no later (dominance; checked in a sharded table).
+//
+// The search runs on every thread of a ThreadPool. Each worker keeps its own
+// deque, working depth-first from the back and stealing from the front of
+// other workers' deques when it runs dry.
+class BuildOrderSolver {
+public:
+    BuildOrderSolver(const GameState& game, SolverGoal goal, int maxPurchases)
+        : game(game), goal(goal), maxPurchases(maxPurchases) {
+        // What one purchase can add to each rate, for the bound: the
+        // undominated (production, bonus) steps, and the largest multiplier
+        for (int r = 0; r < kResourceCount; r++) {
+            maxMultiplier[r] = 1.0;
+            for (const auto& type : game.buildingTypes) {
+                RateStep step{ type.production[r], type.bonus[r] + type.globalBonus };
+                maxMultiplier[r] = std::max(maxMultiplier[r], (1.0 + type.multiplier[r]) * (1.0 + type.globalMultiplier));
+
+                auto& frontier = rateSteps[r];
+                bool dominated = false;
+                for (const RateStep& other : frontier) {
+                    dominated |= other.production >= step.production && other.bonus >= step.bonus;
+                }
+                if (dominated) continue;
+                std::erase_if(frontier, [&](const RateStep& other) {
+                    return step.production >= other.production && step.bonus >= other.bonus;
+                    });
+                frontier.push_back(step);
+            }
+        }
+    }
+
+    SolverResult Solve(ThreadPool& pool) {
+        auto start = std::chrono::steady_clock::now();
+
+        Node root;
+        root.amounts = game.amounts;
+        root.rates = game.rates;
+        for (const auto& building : game.buildings) root.counts.push_back(building.count);
+
+        bestTime.store(std::numeric_limits<double>::infinity());
+        workers.clear();
+        for (int i = 0; i < pool.ThreadCount(); i++) {
+            workers.push_back(std::make_unique<Worker>());
+            workers.back()->graph = game.productionGraph;
+            workers.back()->graph.SetCounts(root.counts);
+        }
+        pending.store(1);
+        workers[0]->nodes.push_back(std::move(root));
+
+        pool.ParallelFor(0, (int64_t)workers.size(), 1, [&](int64_t begin, int64_t) {
+            WorkerLoop((int)begin);
+            });
+
+        SolverResult result;
+        result.found = bestTime.load() < std::numeric_limits<double>::infinity();
+        result.time = bestTime.load();
+        result.purchases = bestPurchases;
+        for (const auto& worker : workers) {
+            result.nodesExpanded += worker->nodesExpanded;
+            result.prunedByBound += worker->prunedByBound;
+            result.prunedByDominance += worker->prunedByDominance;
+            result.steals += worker->steals;
+        }
+        auto end = std::chrono::steady_clock::now();
+        result.wallSeconds = std::chrono::duration<double>(end - start).count();
+        return result;
+    }
+
+private:
+    struct Node {
+        double time = 0.0;
+        ResourceAmounts amounts;
+        ResourceValues rates;
+        std::vector<int> counts;
+        std::vector<int> purchases;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Node> nodes;
+        ModifierGraph<kResourceCount> graph;    // Scratch, for rates at any counts
+        int64_t nodesExpanded = 0;
+        int64_t prunedByBound = 0;
+        int64_t prunedByDominance = 0;
+        int64_t steals = 0;
+    };
+
+    // Best stockpiles seen for one set of building counts: (time, amounts)
+    struct FrontEntry {
+        double time;
+        ResourceAmounts amounts;
+    };
+
+    struct CountsHash {
+        size_t operator()(const std::vector<int>& counts) const {
+            uint64_t hash = 1469598103934665603ull;
+            for (int count : counts) hash = (hash ^ (uint32_t)count) * 1099511628211ull;
+            return (size_t)hash;
+        }
+    };
+
+    struct DominanceShard {
+        std::mutex mutex;
+        std::unordered_map<std::vector<int>, std::vector<FrontEntry>, CountsHash> fronts;
+    };
+
+    static constexpr int kShardCount = 64;
+
+    const GameState& game;
+    SolverGoal goal;
+    int maxPurchases;
+    struct RateStep {
+        double production;
+        double bonus;
+    };
+
+    std::vector<RateStep> rateSteps[kResourceCount];
+    ResourceValues maxMultiplier;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<int64_t> pending{ 0 };
+    DominanceShard shards[kShardCount];
+
+    std::atomic<double> bestTime{ 0.0 };
+    std::mutex bestMutex;
+    std::vector<int> bestPurchases;
+
+    void WorkerLoop(int id) {
+        Worker& self = *workers[id];
+        while (pending.load() > 0) {
+            Node node;
+            if (!PopLocal(self, node) && !Steal(id, node)) {
+                std::this_thread::yield();
+                continue;
+            }
+            Expand(self, node);
+            pending.fetch_sub(1);
+        }
+    }
+
+    bool PopLocal(Worker& self, Node& node) {
+        std::lock_guard<std::mutex> lock(self.mutex);
+        if (self.nodes.empty()) return false;
+        node = std::move(self.nodes.back());
+        self.nodes.pop_back();
+        return true;
+    }
+
+    // Take the oldest (shallowest, so largest) subtree from another worker
+    bool Steal(int id, Node& node) {
+        for (size_t i = 1; i < workers.size(); i++) {
+            Worker& victim = *workers[(id + i) % workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.nodes.empty()) continue;
+            node = std::move(victim.nodes.front());
+            victim.nodes.pop_front();
+            workers[id]->steals++;
+            return true;
+        }
+        return false;
+    }
+
+    void Expand(Worker& self, Node& node) {
+        self.nodesExpanded++;
+
+        if (GoalReached(node)) {
+            OfferSolution(node.time, node.purchases);
+            return;
+        }
+
+        // The incumbent may have improved since this node was queued
+        int depth = (int)node.purchases.size();
+        if (LowerBound(self, node, maxPurchases - depth) >= bestTime.load()) {
+            self.prunedByBound++;
+            return;
+        }
+
+        // Resource goals can also be reached by simply waiting from here
+        if (goal.kind == SolverGoal::Kind::ResourceAmount) {
+            double wait = WaitForAmount(node, (int)goal.resource, goal.amount);
+            if (wait < std::numeric_limits<double>::infinity()) OfferSolution(node.time + wait, node.purchases);
+        }
+
+        if (depth >= maxPurchases) return;
+
+        // Children ordered by bound, pushed worst first so the most promising
+        // one is popped next
+        std::vector<std::pair<double, Node>> children;
+        for (int b = 0; b < (int)node.counts.size(); b++) {
+            Building building(&game.buildingTypes[b], node.counts[b]);
+            ResourceAmounts cost = building.GetNextCost();
+
+            double wait = 0.0;
+            for (int r = 0; r < kResourceCount; r++) {
+                double need = WaitForAmount(node, r, cost[r]);
+                wait = std::max(wait, need);
+            }
+            if (wait == std::numeric_limits<double>::infinity()) continue;
+
+            Node child;
+            child.time = node.time + wait;
+            child.counts = node.counts;
+            child.counts[b]++;
+            self.graph.SetCounts(child.counts);
+            for (int r = 0; r < kResourceCount; r++) {
+                child.amounts[r] = node.amounts[r] + node.rates[r] * wait;
+                // Absorb rounding at the exact affordability time
+                child.amounts[r] = std::max(child.amounts[r], cost[r]);
+                child.amounts[r] -= cost[r];
+                child.rates[r] = self.graph.Rates()[r];
+            }
+            child.purchases = node.purchases;
+            child.purchases.push_back(b);
+
+            double bound = LowerBound(self, child, maxPurchases - depth - 1);
+            if (bound >= bestTime.load()) {
+                self.prunedByBound++;
+                continue;
+            }
+            if (IsDominated(child)) {
+                self.prunedByDominance++;
+                continue;
+            }
+            children.emplace_back(bound, std::move(child));
+        }
+
+        std::sort(children.begin(), children.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        std::lock_guard<std::mutex> lock(self.mutex);
+        pending.fetch_add((int64_t)children.size());
+        for (auto& child : children) self.nodes.push_back(std::move(child.second));
+    }
+
+    bool GoalReached(const Node& node) const {
+        if (goal.kind == SolverGoal::Kind::BuildingCount) {
+            return node.counts[goal.buildingIndex] >= goal.count;
+        }
+        return node.amounts[goal.resource] >= goal.amount;
+    }
+
+    // Seconds until resource r reaches target at the node's current rate
+    static double WaitForAmount(const Node& node, int r, const BigNumber& target) {
+        BigNumber shortfall = target - node.amounts[r];
+        if (shortfall <= 0.0) return 0.0;
+        if (node.rates[r] <= 0.0) return std::numeric_limits<double>::infinity();
+        return (shortfall / node.rates[r]).ToDouble();
+    }
+
+    // Optimistic finish time: pretend every remaining purchase is made right
+    // now, for free, with the best mix of buildings for each needed resource.
+    // Modifiers are never negative, so no real purchase order can do better.
+    double LowerBound(Worker& self, const Node& node, int remainingPurchases) {
+        if (GoalReached(node)) return node.time;
+
+        ResourceAmounts target;
+        if (goal.kind == SolverGoal::Kind::BuildingCount) {
+            // At least the next goal building must still be paid for
+            target = Building(&game.buildingTypes[goal.buildingIndex], node.counts[goal.buildingIndex]).GetNextCost();
+            if (remainingPurchases <= 0) return std::numeric_limits<double>::infinity();
+        }
+        else {
+            target[goal.resource] = goal.amount;
+        }
+
+        self.graph.SetCounts(node.counts);
+        int k = std::max(0, remainingPurchases);
+
+        double wait = 0.0;
+        for (int r = 0; r < kResourceCount; r++) {
+            BigNumber shortfall = target[r] - node.amounts[r];
+            if (shortfall <= 0.0) continue;
+            double optimisticRate = MaxFlatTimesBonus(r, self.graph.Flat(r), 1.0 + self.graph.Bonus(r), k)
+                * self.graph.Multiplier(r) * std::pow(maxMultiplier[r], k);
+            if (optimisticRate <= 0.0) return std::numeric_limits<double>::infinity();
+            wait = std::max(wait, (shortfall / optimisticRate).ToDouble());
+        }
+        return node.time + wait;
+    }
+
+    // Largest (flat + production) * (bonus + added bonus) that k purchases
+    // can reach. Relaxed to fractional purchases, the reachable sums form a
+    // polygon whose best point lies on an edge between two undominated
+    // steps, so trying every pair of them is enough.
+    double MaxFlatTimesBonus(int r, double flat, double bonus, int k) const {
+        double best = flat * bonus;
+        for (const RateStep& a : rateSteps[r]) {
+            for (const RateStep& b : rateSteps[r]) {
+                // j purchases of a and k - j of b: a quadratic in j
+                double x = flat + k * b.production, dx = a.production - b.production;
+                double y = bonus + k * b.bonus, dy = a.bonus - b.bonus;
+                auto value = [&](double j) { return (x + j * dx) * (y + j * dy); };
+                best = std::max({ best, value(0.0), value(k) });
+                if (dx * dy < 0.0) {
+                    double j = -(x * dy + y * dx) / (2.0 * dx * dy);
+                    if (j > 0.0 && j < k) best = std::max(best, value(j));
+                }
+            }
+        }
+        return best;
+    }
+
+    // Same counts means same rates, so an earlier state can simply wait:
+    // it dominates if its stockpile after waiting covers the later one
+    static bool Dominates(const FrontEntry& a, const FrontEntry& b, const ResourceValues& rates) {
+        if (a.time > b.time) return false;
+        double wait = b.time - a.time;
+        for (int r = 0; r < kResourceCount; r++) {
+            if (a.amounts[r] + rates[r] * wait < b.amounts[r]) return false;
+        }
+        return true;
+    }
+
+    bool IsDominated(const Node& node) {
+        FrontEntry entry{ node.time, node.amounts };
+        DominanceShard& shard = shards[CountsHash()(node.counts) % kShardCount];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto& front = shard.fronts[node.counts];
+        for (const auto& existing : front) {
+            if (Dominates(existing, entry, node.rates)) return true;
+        }
+
+        front.erase(std::remove_if(front.begin(), front.end(),
+            [&](const FrontEntry& existing) { return Dominates(entry, existing, node.rates); }), front.end());
+        front.push_back(entry);
+        return false;
+    }
+
+    void OfferSolution(double time, const std::vector<int>& purchases) {
+        std::lock_guard<std::mutex> lock(bestMutex);
+        if (time >= bestTime.load()) return;
+        bestTime.store(time);
+        bestPurchases = purchases;
+    }
+};
\ No newline at end of file
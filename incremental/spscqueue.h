@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Push and Pop never block and never allocate; Push fails when the
+// queue is full. Capacity is rounded up to a power of two.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer thread only
+    bool Push(const T& value) {
+        size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (tail - cachedHead > mask) return false;
+        }
+        slots[tail & mask] = value;
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool Pop(T& value) {
+        size_t head = this->head.load(std::memory_order_relaxed);
+        if (head == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (head == cachedTail) return false;
+        }
+        value = slots[head & mask];
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Either thread; exact only when the other side is idle
+    size_t SizeApprox() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    size_t Capacity() const { return mask + 1; }
+
+private:
+    std::vector<T> slots;
+    size_t mask = 0;
+
+    // Each index lives on its own cache line with the other side's cached
+    // copy of the opposite index, so the threads do not share lines they write
+    alignas(64) std::atomic<size_t> head{ 0 };
+    size_t cachedTail = 0;                          // Consumer's view of tail
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    size_t cachedHead = 0;                          // Producer's view of head
+};
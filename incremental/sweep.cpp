@@ -0,0 +1,130 @@
+// Balance parameter sweep command line tool. Runs the scripted player for
+// every combination of the given parameter ranges and writes one CSV row per
+// run, e.g.
+//
+//   incremental_sweep --param growth=1.05:1.25:21 --param rate.Food=0.5:2:16 --reach Gold=1e6
+//   incremental_sweep --param cost.Mine.Wood=50:500:10 --hours 168 --out mine.csv
+//
+// Options:
+//   --param KEY=FROM:TO:STEPS  A swept parameter (repeatable); keys are growth,
+//                              growth.Building, rate.Resource,
+//                              cost.Building.Resource, produces.Building.Resource
+//   --hours H                  Simulated time per run (default 24)
+//   --sample H                 Resource curve interval in hours, 0 for none (default 1)
+//   --reach NAME=AMOUNT        Report when a stockpile is first reached (repeatable)
+//   --max-purchases N          Purchases per run before buying stops (default 100000)
+//   --threads N                Worker threads (default: all cores)
+//   --defs FILE                Load content from a definition file
+//   --out FILE                 CSV output (default: standard output)
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "definitions.h"
+#include "sweep.h"
+
+static void PrintUsage() {
+    fprintf(stderr, "usage: incremental_sweep --param KEY=FROM:TO:STEPS [--param ...] [--hours H] [--sample H]\n"
+        "                         [--reach NAME=AMOUNT ...] [--max-purchases N] [--threads N]\n"
+        "                         [--defs FILE] [--out FILE]\n");
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> parameterSpecs;
+    std::vector<std::string> milestoneSpecs;
+    SweepSettings settings;
+    int threads = 0;
+    std::string definitionsPath;
+    std::string outputPath;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--param") == 0 && hasValue) parameterSpecs.push_back(argv[++i]);
+        else if (strcmp(arg, "--hours") == 0 && hasValue) settings.seconds = atof(argv[++i]) * 3600.0;
+        else if (strcmp(arg, "--sample") == 0 && hasValue) settings.sampleInterval = atof(argv[++i]) * 3600.0;
+        else if (strcmp(arg, "--reach") == 0 && hasValue) milestoneSpecs.push_back(argv[++i]);
+        else if (strcmp(arg, "--max-purchases") == 0 && hasValue) settings.maxPurchases = atoi(argv[++i]);
+        else if (strcmp(arg, "--threads") == 0 && hasValue) threads = atoi(argv[++i]);
+        else if (strcmp(arg, "--defs") == 0 && hasValue) definitionsPath = argv[++i];
+        else if (strcmp(arg, "--out") == 0 && hasValue) outputPath = argv[++i];
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (parameterSpecs.empty() || settings.seconds <= 0.0) {
+        PrintUsage();
+        return 1;
+    }
+
+    Definitions content;
+    if (!definitionsPath.empty()) {
+        std::string error;
+        if (!LoadDefinitions(definitionsPath, DefaultCachePath(definitionsPath), content, &error)) {
+            fprintf(stderr, "%s: %s\n", definitionsPath.c_str(), error.c_str());
+            return 1;
+        }
+    }
+    else {
+        content = CaptureDefinitions(GameState());
+    }
+
+    std::vector<SweepParameter> parameters;
+    for (const std::string& spec : parameterSpecs) {
+        SweepParameter parameter;
+        std::string error;
+        if (!ParseSweepParameter(spec, content, parameter, &error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        parameters.push_back(parameter);
+    }
+
+    for (const std::string& spec : milestoneSpecs) {
+        size_t equals = spec.find('=');
+        std::string name = spec.substr(0, equals);
+        SweepMilestone milestone;
+        milestone.resource = -1;
+        for (int r = 0; r < kResourceCount; r++) {
+            if (NarrowUtf8(content.resources[r].name) == name) milestone.resource = r;
+        }
+        if (equals == std::string::npos || milestone.resource < 0) {
+            fprintf(stderr, "%s: expected Resource=amount\n", spec.c_str());
+            return 1;
+        }
+        milestone.amount = atof(spec.c_str() + equals + 1);
+        settings.milestones.push_back(milestone);
+    }
+
+    FILE* output = stdout;
+    if (!outputPath.empty()) {
+        output = fopen(outputPath.c_str(), "wb");
+        if (!output) {
+            fprintf(stderr, "%s: cannot open for writing\n", outputPath.c_str());
+            return 1;
+        }
+    }
+
+    ThreadPool pool(threads);
+    SweepRunner runner(content, parameters, settings);
+    SweepCsvWriter writer(output);
+    writer.WriteHeader(content, parameters, settings);
+
+    auto start = std::chrono::steady_clock::now();
+    runner.Run(pool, writer);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool failed = writer.Failed() || fflush(output) != 0;
+    if (output != stdout) failed |= fclose(output) != 0;
+    if (failed) {
+        fprintf(stderr, "error writing %s\n", outputPath.empty() ? "output" : outputPath.c_str());
+        return 1;
+    }
+
+    fprintf(stderr, "%lld runs, %.0f simulated hours in %.3f s on %d threads (%.3g simulated hours/minute)\n",
+        (long long)runner.RunsCompleted(), runner.SimulatedHours(), seconds, pool.ThreadCount(),
+        seconds > 0.0 ? runner.SimulatedHours() * 60.0 / seconds : 0.0);
+    return 0;
+}
@@ -0,0 +1,416 @@
+#pragma once
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "definitions.h"
+#include "threadpool.h"
+
+// Balance parameter sweeps.
+//
+// A sweep takes ranges for content parameters (cost growth, base rates,
+// building costs and production), runs a scripted player for every
+// combination of them, and streams one CSV row per run as runs finish.
+// Rows carry the run index, so consumers can restore the order; nothing is
+// kept in memory after a row is written, so a sweep can be any length.
+//
+// Runs are independent, so they are spread over a ThreadPool. Each run is
+// simulated in closed form between purchases (like GameState::Advance), so
+// its cost grows with the number of purchases, not the simulated time.
+
+enum class SweepTarget {
+    Growth,         // BuildingType::costGrowth
+    Rate,           // Base production rate of a resource
+    Cost,           // One building's base cost in one resource
+    Production,     // One building's production of one resource
+};
+
+// One swept parameter: `steps` evenly spaced values from `from` to `to`
+struct SweepParameter {
+    std::string name;               // As written on the command line; also the CSV column
+    SweepTarget target = SweepTarget::Growth;
+    int building = -1;              // -1 for every building (growth only)
+    int resource = -1;
+    double from = 0.0;
+    double to = 0.0;
+    int steps = 1;
+
+    double Value(int step) const {
+        if (steps <= 1) return from;
+        return from + (to - from) * step / (steps - 1);
+    }
+
+    void Apply(double value, Definitions& definitions) const {
+        switch (target) {
+        case SweepTarget::Growth:
+            for (int b = 0; b < (int)definitions.buildingTypes.size(); b++) {
+                if (building < 0 || building == b) definitions.buildingTypes[b].costGrowth = value;
+            }
+            break;
+        case SweepTarget::Rate:
+            definitions.resources[resource].baseRate = value;
+            break;
+        case SweepTarget::Cost:
+            definitions.buildingTypes[building].cost[resource] = value;
+            break;
+        case SweepTarget::Production:
+            definitions.buildingTypes[building].production[resource] = value;
+            break;
+        }
+    }
+};
+
+// Parse "key=from:to:steps" (or "key=value" for a single value). Keys
+// follow the definition file:
+//
+//   growth                 cost growth of every building
+//   growth.Farm            cost growth of one building
+//   rate.Food              base rate of a resource
+//   cost.Farm.Wood         a building's cost in one resource
+//   produces.Mine.Gold     a building's production of one resource
+inline bool ParseSweepParameter(const std::string& spec, const Definitions& content, SweepParameter& parameter,
+    std::string* error = nullptr) {
+    auto fail = [&](const std::string& message) {
+        if (error) *error = spec + ": " + message;
+        return false;
+    };
+    auto findResource = [&](const std::string& name) {
+        for (int r = 0; r < kResourceCount; r++) {
+            if (NarrowUtf8(content.resources[r].name) == name) return r;
+        }
+        return -1;
+    };
+    auto findBuilding = [&](const std::string& name) {
+        for (int b = 0; b < (int)content.buildingTypes.size(); b++) {
+            if (NarrowUtf8(content.buildingTypes[b].name) == name) return b;
+        }
+        return -1;
+    };
+
+    size_t equals = spec.find('=');
+    if (equals == std::string::npos) return fail("expected key=from:to:steps");
+    SweepParameter result;
+    result.name = spec.substr(0, equals);
+
+    // Range
+    std::string range = spec.substr(equals + 1);
+    char* end = nullptr;
+    result.from = strtod(range.c_str(), &end);
+    if (end == range.c_str()) return fail("expected a number");
+    result.to = result.from;
+    if (*end == ':') {
+        const char* start = end + 1;
+        result.to = strtod(start, &end);
+        if (end == start || *end != ':') return fail("expected from:to:steps");
+        start = end + 1;
+        result.steps = (int)strtol(start, &end, 10);
+        if (end == start || result.steps < 1) return fail("expected a step count of at least 1");
+    }
+    if (*end != '\0') return fail("unexpected text after the range");
+
+    // Key: prefix, then an optional building and/or resource
+    const std::string& key = result.name;
+    size_t firstDot = key.find('.');
+    std::string prefix = key.substr(0, firstDot);
+    std::string rest = firstDot == std::string::npos ? std::string() : key.substr(firstDot + 1);
+
+    if (prefix == "growth") {
+        result.target = SweepTarget::Growth;
+        if (!rest.empty()) {
+            result.building = findBuilding(rest);
+            if (result.building < 0) return fail("unknown building " + rest);
+        }
+        if (std::min(result.from, result.to) < 1.0) return fail("growth must be at least 1");
+    }
+    else if (prefix == "rate") {
+        result.target = SweepTarget::Rate;
+        result.resource = findResource(rest);
+        if (result.resource < 0) return fail("unknown resource " + rest);
+    }
+    else if (prefix == "cost" || prefix == "produces") {
+        result.target = prefix == "cost" ? SweepTarget::Cost : SweepTarget::Production;
+
+        // Building names may contain dots; the resource is after the last one
+        size_t lastDot = rest.rfind('.');
+        if (lastDot == std::string::npos) return fail("expected " + prefix + ".Building.Resource");
+        std::string buildingName = rest.substr(0, lastDot);
+        std::string resourceName = rest.substr(lastDot + 1);
+        result.building = findBuilding(buildingName);
+        if (result.building < 0) return fail("unknown building " + buildingName);
+        result.resource = findResource(resourceName);
+        if (result.resource < 0) return fail("unknown resource " + resourceName);
+    }
+    else {
+        return fail("unknown parameter " + prefix);
+    }
+
+    parameter = result;
+    return true;
+}
+
+// A stockpile to reach; its time is reported per run
+struct SweepMilestone {
+    int resource = 0;
+    double amount = 0.0;
+};
+
+struct SweepSettings {
+    double seconds = 24.0 * 3600.0;     // Simulated time per run
+    double sampleInterval = 3600.0;     // Resource curve resolution; 0 for no curve
+    int maxPurchases = 100000;          // Safety limit for content that never gets expensive
+    std::vector<SweepMilestone> milestones;
+
+    int SampleCount() const {
+        return sampleInterval > 0.0 ? (int)std::floor(seconds / sampleInterval + 1e-9) : 0;
+    }
+};
+
+// What one run measured. Times are seconds into the run, NaN if never.
+struct SweepRun {
+    std::vector<double> firstOwned;     // Per building type
+    std::vector<double> milestoneTimes; // Per SweepSettings::milestones
+    std::vector<double> samples;        // Every resource at each sample time, sample-major
+    int purchases = 0;
+    bool truncated = false;             // Stopped buying at maxPurchases
+};
+
+// The scripted player: buys any building the moment it becomes affordable,
+// earliest first and ties to the lower index, exactly like GameState::Advance
+// with every building on auto-purchase. It gathers nothing. Between
+// purchases every stockpile grows linearly, so samples and milestones inside
+// a segment are solved in closed form too.
+inline void RunScriptedPlayer(GameState& game, const SweepSettings& settings, SweepRun& run) {
+    const double kNever = std::numeric_limits<double>::quiet_NaN();
+    int buildingCount = (int)game.buildings.size();
+    int sampleCount = settings.SampleCount();
+
+    run.firstOwned.assign(buildingCount, kNever);
+    run.milestoneTimes.assign(settings.milestones.size(), kNever);
+    run.samples.assign((size_t)sampleCount * kResourceCount, 0.0);
+    run.purchases = 0;
+    run.truncated = false;
+    for (int b = 0; b < buildingCount; b++) {
+        if (game.buildings[b].count > 0) run.firstOwned[b] = 0.0;
+    }
+
+    double time = 0.0;
+    int nextSample = 1;
+
+    // Milestones are checked at the start of each segment, where stockpiles
+    // are lowest (after a purchase), and solved along it
+    auto advanceTo = [&](double target) {
+        for (size_t m = 0; m < settings.milestones.size(); m++) {
+            if (!std::isnan(run.milestoneTimes[m])) continue;
+            const SweepMilestone& milestone = settings.milestones[m];
+            BigNumber shortfall = BigNumber(milestone.amount) - game.amounts[milestone.resource];
+            if (shortfall <= 0.0) {
+                run.milestoneTimes[m] = time;
+                continue;
+            }
+            double rate = game.rates[milestone.resource];
+            if (rate <= 0.0) continue;
+            double hit = time + (shortfall / rate).ToDouble();
+            if (hit <= target) run.milestoneTimes[m] = hit;
+        }
+
+        if (target > time) game.AdvanceLinear(target - time);
+        time = target;
+    };
+
+    while (true) {
+        int next = -1;
+        double wait = std::numeric_limits<double>::infinity();
+        if (run.purchases < settings.maxPurchases) {
+            for (int b = 0; b < buildingCount; b++) {
+                double w = game.TimeUntilAffordable(b);
+                if (w < wait) {
+                    wait = w;
+                    next = b;
+                }
+            }
+        }
+
+        bool buys = next >= 0 && time + wait <= settings.seconds;
+        double end = buys ? time + wait : settings.seconds;
+        while (nextSample <= sampleCount && nextSample * settings.sampleInterval <= end) {
+            advanceTo(nextSample * settings.sampleInterval);
+            double* sample = &run.samples[(size_t)(nextSample - 1) * kResourceCount];
+            for (int r = 0; r < kResourceCount; r++) sample[r] = game.amounts[r].ToDouble();
+            nextSample++;
+        }
+        advanceTo(end);
+        if (!buys) break;
+
+        // Absorb rounding at the exact affordability time, as Advance does
+        const ResourceAmounts& cost = game.buildings[next].GetNextCost();
+        for (int r = 0; r < kResourceCount; r++) {
+            if (game.amounts[r] < cost[r]) {
+                game.amounts[r] = cost[r];
+                game.amountVersions[r]++;
+                game.adjustmentVersions[r]++;
+            }
+        }
+        game.PurchaseBuilding(next);
+
+        if (std::isnan(run.firstOwned[next])) run.firstOwned[next] = time;
+        if (++run.purchases == settings.maxPurchases) run.truncated = true;
+    }
+}
+
+// CSV output shared by every worker. Rows are formatted by the caller into
+// its own buffer and written whole under a lock, in completion order.
+class SweepCsvWriter {
+public:
+    explicit SweepCsvWriter(FILE* file) : file(file) {}
+
+    // Column names: run index, parameters, purchase count, first-owned
+    // time per building, milestone times, then the resource curve
+    void WriteHeader(const Definitions& content, const std::vector<SweepParameter>& parameters, const SweepSettings& settings) {
+        std::string header = "run";
+        for (const auto& parameter : parameters) AppendField(header, parameter.name);
+        header += ",purchases,truncated";
+        for (const auto& type : content.buildingTypes) AppendField(header, "first." + NarrowUtf8(type.name));
+        for (const auto& milestone : settings.milestones) {
+            std::string name = "reach." + NarrowUtf8(content.resources[milestone.resource].name) + ".";
+            AppendNumber(name, milestone.amount);
+            AppendField(header, name);
+        }
+        for (int s = 1; s <= settings.SampleCount(); s++) {
+            for (int r = 0; r < kResourceCount; r++) {
+                std::string name = NarrowUtf8(content.resources[r].name) + "@";
+                AppendNumber(name, s * settings.sampleInterval);
+                AppendField(header, name);
+            }
+        }
+        header += '\n';
+        Write(header);
+    }
+
+    static void FormatRow(std::string& row, int64_t index, const std::vector<double>& values, const SweepRun& run) {
+        row.clear();
+        AppendNumber(row, (double)index);
+        for (double value : values) {
+            row += ',';
+            AppendNumber(row, value);
+        }
+        row += ',';
+        AppendNumber(row, run.purchases);
+        row += run.truncated ? ",1" : ",0";
+        for (double time : run.firstOwned) {
+            row += ',';
+            AppendNumber(row, time);
+        }
+        for (double time : run.milestoneTimes) {
+            row += ',';
+            AppendNumber(row, time);
+        }
+        for (double amount : run.samples) {
+            row += ',';
+            AppendNumber(row, amount);
+        }
+        row += '\n';
+    }
+
+    void Write(const std::string& text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fwrite(text.data(), 1, text.size(), file) != text.size()) failed = true;
+    }
+
+    bool Failed() const { return failed; }
+
+    // Shortest text that reads back as the same double; empty for NaN
+    static void AppendNumber(std::string& out, double value) {
+        if (std::isnan(value)) return;
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+private:
+    FILE* file;
+    std::mutex mutex;
+    bool failed = false;
+
+    // Quoted when it would otherwise break the row
+    static void AppendField(std::string& out, const std::string& value) {
+        out += ',';
+        if (value.find_first_of(",\"\n") == std::string::npos) {
+            out += value;
+            return;
+        }
+        out += '"';
+        for (char c : value) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+        out += '"';
+    }
+};
+
+// Every combination of the parameters (the first one varies slowest)
+class SweepRunner {
+public:
+    // Runs per thread-pool task
+    static constexpr int64_t kChunkSize = 8;
+
+    SweepRunner(const Definitions& content, const std::vector<SweepParameter>& parameters, const SweepSettings& settings)
+        : content(content), parameters(parameters), settings(settings) {
+    }
+
+    int64_t CombinationCount() const {
+        int64_t count = 1;
+        for (const auto& parameter : parameters) count *= parameter.steps;
+        return count;
+    }
+
+    // Parameter values of one combination, in parameter order
+    void Combination(int64_t index, std::vector<double>& values) const {
+        values.resize(parameters.size());
+        for (int p = (int)parameters.size() - 1; p >= 0; p--) {
+            values[p] = parameters[p].Value((int)(index % parameters[p].steps));
+            index /= parameters[p].steps;
+        }
+    }
+
+    // Run every combination and write each result as soon as it is done
+    void Run(ThreadPool& pool, SweepCsvWriter& writer) {
+        pool.ParallelFor(0, CombinationCount(), kChunkSize, [&](int64_t begin, int64_t end) {
+            // Scratch reused across the chunk
+            Definitions variant;
+            GameState game;
+            SweepRun run;
+            std::vector<double> values;
+            std::string row;
+
+            for (int64_t index = begin; index < end; index++) {
+                Combination(index, values);
+                variant = content;
+                for (size_t p = 0; p < parameters.size(); p++) parameters[p].Apply(values[p], variant);
+                ApplyDefinitions(variant, game, true);
+
+                RunScriptedPlayer(game, settings, run);
+                SweepCsvWriter::FormatRow(row, index, values, run);
+                writer.Write(row);
+
+                runsCompleted.fetch_add(1, std::memory_order_relaxed);
+                simulatedSeconds.fetch_add((int64_t)settings.seconds, std::memory_order_relaxed);
+            }
+            });
+    }
+
+    int64_t RunsCompleted() const { return runsCompleted.load(); }
+    double SimulatedHours() const { return simulatedSeconds.load() / 3600.0; }
+
+private:
+    Definitions content;
+    std::vector<SweepParameter> parameters;
+    SweepSettings settings;
+    std::atomic<int64_t> runsCompleted{ 0 };
+    std::atomic<int64_t> simulatedSeconds{ 0 };
+};
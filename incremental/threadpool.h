@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool for data-parallel loops. The calling thread joins
+// in on every ParallelFor, so a pool of N threads uses N - 1 workers.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threadCount = 0) {
+        if (threadCount <= 0) threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+        for (int i = 1; i < threadCount; i++) {
+            workers.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int ThreadCount() const { return (int)workers.size() + 1; }
+
+    // Run body(chunkBegin, chunkEnd) over [begin, end) split into chunks of
+    // at most chunkSize, and return once every chunk has finished
+    void ParallelFor(int64_t begin, int64_t end, int64_t chunkSize,
+        const std::function<void(int64_t, int64_t)>& body) {
+        if (end <= begin) return;
+        if (workers.empty() || end - begin <= chunkSize) {
+            body(begin, end);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &body;
+            jobEnd = end;
+            jobChunk = chunkSize;
+            nextChunk.store(begin);
+            activeWorkers = (int)workers.size();
+            generation++;
+        }
+        wake.notify_all();
+
+        RunChunks();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return activeWorkers == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stopping = false;
+    uint64_t generation = 0;
+    int activeWorkers = 0;
+
+    const std::function<void(int64_t, int64_t)>* job = nullptr;
+    int64_t jobEnd = 0;
+    int64_t jobChunk = 1;
+    std::atomic<int64_t> nextChunk{ 0 };
+
+    // Claim chunks until the range is exhausted
+    void RunChunks() {
+        while (true) {
+            int64_t chunkBegin = nextChunk.fetch_add(jobChunk);
+            if (chunkBegin >= jobEnd) return;
+            (*job)(chunkBegin, std::min(chunkBegin + jobChunk, jobEnd));
+        }
+    }
+
+    void WorkerLoop() {
+        uint64_t seenGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+                if (stopping) return;
+                seenGeneration = generation;
+            }
+
+            RunChunks();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--activeWorkers == 0) done.notify_one();
+        }
+    }
+};
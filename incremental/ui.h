@@ -1,34 +1,41 @@
 #pragma once
-#include <windows.h>
-#include <gdiplus.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
 #include <string>
 #include <vector>
-#include <sstream>
-#include <iomanip>
 #include "game.h"
+#include "commandlog.h"
+#include "listlayout.h"
+#include "profiler.h"
+#include "render.h"
+#include "simulation.h"
+#include "uimodel.h"
 
-using namespace Gdiplus;
+// The UI records its drawing into a RenderList (render.h) and never talks to
+// a graphics API, so it runs unchanged against the GDI+ backend in the game
+// and the null backend in headless benchmarks.
 
 // Simple Button class
 class Button {
 public:
     float x, y, width, height;
     std::wstring text;
-    Color normalColor;
-    Color hoverColor;
-    Color pressedColor;
-    Color disabledColor;
+    RenderColor normalColor;
+    RenderColor hoverColor;
+    RenderColor pressedColor;
+    RenderColor disabledColor;
     bool isHovered = false;
     bool isPressed = false;
     bool isEnabled = true;
 
     Button(float x, float y, float width, float height, const std::wstring& text,
-        Color normalColor = Color(255, 70, 70, 70))
+        RenderColor normalColor = MakeColor(255, 70, 70, 70))
         : x(x), y(y), width(width), height(height), text(text),
         normalColor(normalColor),
-        hoverColor(Color(255, 90, 90, 90)),
-        pressedColor(Color(255, 50, 50, 50)),
-        disabledColor(Color(255, 40, 40, 40)) {
+        hoverColor(MakeColor(255, 90, 90, 90)),
+        pressedColor(MakeColor(255, 50, 50, 50)),
+        disabledColor(MakeColor(255, 40, 40, 40)) {
     }
 
     bool Contains(int mouseX, int mouseY) const {
@@ -36,30 +43,23 @@ public:
             mouseY >= y && mouseY <= y + height;
     }
 
-    void Render(Graphics& graphics, Font& font) {
+    void Record(RenderList& list) const {
         // Choose color based on state
-        Color currentColor = normalColor;
+        RenderColor currentColor = normalColor;
         if (!isEnabled) currentColor = disabledColor;
         else if (isPressed) currentColor = pressedColor;
         else if (isHovered) currentColor = hoverColor;
 
-        // Draw button background
-        SolidBrush bgBrush(currentColor);
-        graphics.FillRectangle(&bgBrush, x, y, width, height);
-
-        // Draw border
-        Color borderColor = isEnabled ? Color(255, 150, 150, 150) : Color(255, 80, 80, 80);
-        Pen borderPen(borderColor, 2.0f);
-        graphics.DrawRectangle(&borderPen, x, y, width, height);
-
-        // Draw text centered
-        Color textColor = isEnabled ? Color(255, 255, 255, 255) : Color(255, 120, 120, 120);
-        SolidBrush textBrush(textColor);
-        RectF rect(x, y, width, height);
-        StringFormat format;
-        format.SetAlignment(StringAlignmentCenter);
-        format.SetLineAlignment(StringAlignmentCenter);
-        graphics.DrawString(text.c_str(), -1, &font, rect, &format, &textBrush);
+        RenderRect rect{ x, y, width, height };
+
+        // Background and border
+        list.FillRect(rect, currentColor);
+        RenderColor borderColor = isEnabled ? MakeColor(255, 150, 150, 150) : MakeColor(255, 80, 80, 80);
+        list.StrokeRect(rect, borderColor, 2.0f);
+
+        // Text centered
+        RenderColor textColor = isEnabled ? MakeColor(255, 255, 255, 255) : MakeColor(255, 120, 120, 120);
+        list.Text(text, rect, RenderFont::Button, textColor, TextAlign::Center);
     }
 };
 
@@ -67,6 +67,10 @@ public:
 class UIManager {
 public:
     std::vector<Button> gatherButtons;
+
+    // Building buttons exist only for the visible part of the list:
+    // buildingButtons[k] shows building buildingList.VisibleBegin() + k
+    ListLayout buildingList;
     std::vector<Button> buildingButtons;
 
     std::wstring clickFeedback;
@@ -76,6 +80,32 @@ public:
     int mouseY = 0;
     bool mouseDown = false;
 
+    // Player actions are recorded here when set
+    CommandLog* commandLog = nullptr;
+
+    // When set, player actions are queued for the simulation thread instead
+    // of applied directly, and feedback appears when their results come back
+    SimulationThread* simulation = nullptr;
+
+    // Gather clicks are merged here, one command per resource, and go to
+    // the simulation once per frame or ahead of the next other command, so
+    // a click flood costs the queue a few entries a frame.
+    Command pendingGathers[kResourceCount] = {};
+
+    // Clicks that found the simulation queue full are never dropped: they
+    // wait here in click order and are resubmitted on the next frame.
+    // Gathers since the last other command merge per resource.
+    std::deque<Command> deferredCommands;
+    int64_t clicksDeferred = 0;         // Clicks that had to wait for queue space
+
+    // Cached text and enabled state, rebuilt only when the game changes
+    UIModel model;
+    double clock = 0.0;                 // Seconds since start, for affordability times
+
+    // Frame-time histogram overlay, fed by the caller once per frame
+    FrameTimeStats frameTimes;
+    bool showProfiler = false;
+
     void Initialize() {
         InitializeGatherButtons();
         InitializeBuildingButtons();
@@ -89,60 +119,57 @@ public:
         float buttonSpacing = 55.0f;
 
         gatherButtons.push_back(Button(buttonX, buttonY, buttonWidth, buttonHeight,
-            L"Gather Food (+5)", Color(255, 50, 150, 50)));
+            L"Gather Food (+5)", MakeColor(255, 50, 150, 50)));
         buttonY += buttonSpacing;
 
         gatherButtons.push_back(Button(buttonX, buttonY, buttonWidth, buttonHeight,
-            L"Chop Wood (+3)", Color(255, 100, 50, 0)));
+            L"Chop Wood (+3)", MakeColor(255, 100, 50, 0)));
         buttonY += buttonSpacing;
 
         gatherButtons.push_back(Button(buttonX, buttonY, buttonWidth, buttonHeight,
-            L"Mine Stone (+2)", Color(255, 80, 80, 80)));
+            L"Mine Stone (+2)", MakeColor(255, 80, 80, 80)));
         buttonY += buttonSpacing;
 
         gatherButtons.push_back(Button(buttonX, buttonY, buttonWidth, buttonHeight,
-            L"Pan Gold (+1)", Color(255, 180, 150, 0)));
+            L"Pan Gold (+1)", MakeColor(255, 180, 150, 0)));
     }
 
+    // Three columns of buttons with room for the cost line under each;
+    // the list scrolls when there are more buildings than fit
     void InitializeBuildingButtons() {
-        float buttonX = 400.0f;
-        float buttonY = 350.0f;
-        float buttonWidth = 160.0f;
-        float buttonHeight = 60.0f;
-        float buttonSpacingX = 170.0f;
-        float buttonSpacingY = 70.0f;
-
-        // Create buttons for each building type (will be filled with actual building names later)
-        for (int i = 0; i < 5; i++) {
-            float x = buttonX + (i % 3) * buttonSpacingX;
-            float y = buttonY + (i / 3) * buttonSpacingY;
-
-            buildingButtons.push_back(Button(x, y, buttonWidth, buttonHeight,
-                L"Building", Color(255, 60, 60, 100)));
-        }
+        RenderRect viewport{ 400.0f, 350.0f, 500.0f, 300.0f };
+        buildingList = ListLayout(viewport, 160.0f, 60.0f, 10.0f, 20.0f);
+        buildingButtons.clear();
+        buttonsBegin = 0;
     }
 
-    void Update(float deltaTime, GameState& game) {
+    void Update(float deltaTime, const GameState& game) {
+        PROFILE_ZONE("UIManager::Update");
+        clock += deltaTime;
+
+        Command result;
+        while (simulation && simulation->PollResult(result)) ShowResult(result, game);
+        if (simulation) {
+            SubmitDeferredCommands();
+            FlushGathers();
+        }
+
+        // Only the visible buildings get widgets and buttons
+        buildingList.SetItemCount((int)game.buildings.size());
+        model.BeginFrame();
+        model.SetVisibleBuildings(buildingList.VisibleBegin(), buildingList.VisibleEnd());
+        model.Update(game, clock);
+        LayoutBuildingButtons();
+
         // Update button hover states
         for (auto& button : gatherButtons) {
             button.isHovered = button.Contains(mouseX, mouseY);
             if (!mouseDown) button.isPressed = false;
         }
 
-        for (size_t i = 0; i < buildingButtons.size(); i++) {
-            buildingButtons[i].isHovered = buildingButtons[i].Contains(mouseX, mouseY);
-            if (!mouseDown) buildingButtons[i].isPressed = false;
-
-            // Update enabled state based on affordability
-            buildingButtons[i].isEnabled = game.CanAfford(i);
-
-            // Update button text with building info
-            if (i < game.buildings.size()) {
-                const auto& building = game.buildings[i];
-                std::wstringstream ss;
-                ss << building.type->name << L" (" << building.count << L")";
-                buildingButtons[i].text = ss.str();
-            }
+        for (auto& button : buildingButtons) {
+            button.isHovered = button.Contains(mouseX, mouseY);
+            if (!mouseDown) button.isPressed = false;
         }
 
         // Update click feedback
@@ -154,40 +181,106 @@ public:
         }
     }
 
-    void HandleGatherButtonClick(int buttonIndex, GameState& game) {
-        switch (buttonIndex) {
-        case 0:
-            game.GatherResource(ResourceType::Food, 5.0);
-            clickFeedback = L"+5 Food!";
-            feedbackTimer = 1.0f;
-            break;
-        case 1:
-            game.GatherResource(ResourceType::Wood, 3.0);
-            clickFeedback = L"+3 Wood!";
-            feedbackTimer = 1.0f;
-            break;
-        case 2:
-            game.GatherResource(ResourceType::Stone, 2.0);
-            clickFeedback = L"+2 Stone!";
-            feedbackTimer = 1.0f;
-            break;
-        case 3:
-            game.GatherResource(ResourceType::Gold, 1.0);
-            clickFeedback = L"+1 Gold!";
-            feedbackTimer = 1.0f;
-            break;
+    void ExecuteCommand(GameState& game, Command command) {
+        if (simulation) {
+            if (command.type == CommandType::Gather && command.index >= 0 && command.index < kResourceCount) {
+                Command& pending = pendingGathers[command.index];
+                if (pending.count == 0) {
+                    pending = command;
+                }
+                else {
+                    pending.value += command.value;
+                    pending.count += command.count;
+                }
+                return;
+            }
+
+            // Gathers clicked earlier go first: the command may spend them
+            FlushGathers();
+            SubmitInOrder(command);
+            return;
         }
+
+        bool succeeded = commandLog ? commandLog->Execute(game, command) : ApplyCommand(game, command);
+        command.succeeded = succeeded ? 1 : 0;
+        ShowResult(command, game);
     }
 
-    void HandleBuildingButtonClick(int buttonIndex, GameState& game) {
-        if (game.PurchaseBuilding(buttonIndex)) {
-            clickFeedback = L"Built " + game.buildings[buttonIndex].type->name + L"!";
-            feedbackTimer = 1.5f;
+    // Hand the merged gathers to the simulation
+    void FlushGathers() {
+        for (Command& pending : pendingGathers) {
+            if (pending.count == 0) continue;
+            SubmitInOrder(pending);
+            pending = Command{};
         }
-        else {
-            clickFeedback = L"Not enough resources!";
+    }
+
+    // While commands wait for queue space, new ones go after them; the next
+    // frame resubmits them
+    void SubmitInOrder(const Command& command) {
+        if (!HasDeferredCommands() && simulation->Submit(command)) return;
+        DeferCommand(command);
+    }
+
+    // Queue a command behind the others waiting. A gather joins one of the
+    // same resource in the trailing run of gathers, so an auto-clicker
+    // leaves at most one waiting gather per resource between other commands.
+    void DeferCommand(const Command& command) {
+        clicksDeferred += command.type == CommandType::Gather ? command.count : 1;
+        if (command.type == CommandType::Gather) {
+            for (auto it = deferredCommands.rbegin(); it != deferredCommands.rend() && it->type == CommandType::Gather; ++it) {
+                if (it->index != command.index) continue;
+                it->value += command.value;
+                it->count += command.count;
+                return;
+            }
+        }
+        deferredCommands.push_back(command);
+    }
+
+    // Submit waiting commands in order. Returns true once none are left.
+    bool SubmitDeferredCommands() {
+        while (!deferredCommands.empty()) {
+            if (!simulation->Submit(deferredCommands.front())) return false;
+            deferredCommands.pop_front();
+        }
+        return true;
+    }
+
+    bool HasDeferredCommands() const { return !deferredCommands.empty(); }
+
+    // Anything not yet handed to the simulation: merged gathers included
+    bool HasPendingCommands() const {
+        bool pending = HasDeferredCommands();
+        for (const Command& gather : pendingGathers) pending |= gather.count != 0;
+        return pending;
+    }
+
+    void ShowResult(const Command& command, const GameState& game) {
+        if (command.type == CommandType::Gather && command.succeeded) {
+            clickFeedback = L"+" + std::to_wstring((int)command.value) + L" " + game.resourceNames[command.index] + L"!";
             feedbackTimer = 1.0f;
         }
+        else if (command.type == CommandType::Purchase) {
+            if (command.succeeded && command.index >= 0 && command.index < (int)game.buildings.size()) {
+                clickFeedback = L"Built " + game.buildings[command.index].type->name + L"!";
+                feedbackTimer = 1.5f;
+            }
+            else {
+                clickFeedback = L"Not enough resources!";
+                feedbackTimer = 1.0f;
+            }
+        }
+    }
+
+    void HandleGatherButtonClick(int buttonIndex, GameState& game) {
+        static const double amounts[kResourceCount] = { 5.0, 3.0, 2.0, 1.0 };
+        if (buttonIndex < 0 || buttonIndex >= kResourceCount) return;
+        ExecuteCommand(game, Command::Gather((ResourceType)buttonIndex, amounts[buttonIndex]));
+    }
+
+    void HandleBuildingButtonClick(int buildingIndex, GameState& game) {
+        ExecuteCommand(game, Command::Purchase(buildingIndex));
     }
 
     void HandleMouseDown(int x, int y, GameState& game) {
@@ -202,14 +295,38 @@ public:
             }
         }
 
-        // Check building buttons
-        for (size_t i = 0; i < buildingButtons.size(); i++) {
-            if (buildingButtons[i].Contains(x, y) && buildingButtons[i].isEnabled) {
-                buildingButtons[i].isPressed = true;
-                HandleBuildingButtonClick(i, game);
-                return;
-            }
+        // Building buttons: the layout finds the cell directly
+        int item = buildingList.HitTest((float)x, (float)y);
+        int k = item - buttonsBegin;
+        if (item >= 0 && k < (int)buildingButtons.size() && buildingButtons[k].isEnabled) {
+            buildingButtons[k].isPressed = true;
+            HandleBuildingButtonClick(item, game);
+            return;
         }
+
+        // Clicking the scroll track above or below the thumb pages the list
+        RenderRect track = buildingList.ScrollTrack(kScrollBarWidth);
+        if (!track.IsEmpty() && x >= track.x && x <= track.Right() && y >= track.y && y <= track.Bottom()) {
+            RenderRect thumb = buildingList.ScrollThumb(kScrollBarWidth);
+            int page = buildingList.VisibleRows();
+            if (y < thumb.y) ScrollBuildings(-page);
+            else if (y > thumb.Bottom()) ScrollBuildings(page);
+        }
+    }
+
+    // `delta` as in WM_MOUSEWHEEL: positive away from the user, 120 per notch
+    void HandleMouseWheel(int x, int y, int delta) {
+        RenderRect area = RenderRect::Union(buildingList.viewport, buildingList.ScrollTrack(kScrollBarWidth));
+        if (x < area.x || x > area.Right() || y < area.y || y > area.Bottom()) return;
+        // Touchpads send fractions of a notch; scroll once they add up
+        wheelDelta += delta;
+        int rows = -wheelDelta / 120;
+        wheelDelta %= 120;
+        ScrollBuildings(rows);
+    }
+
+    void ScrollBuildings(int rows) {
+        if (buildingList.ScrollRows(rows)) LayoutBuildingButtons();
     }
 
     void HandleMouseUp() {
@@ -223,138 +340,154 @@ public:
         mouseY = y;
     }
 
-    void Render(HDC hdc, int width, int height, const GameState& game, int fps) {
-        Graphics graphics(hdc);
-        graphics.SetSmoothingMode(SmoothingModeAntiAlias);
-        graphics.SetTextRenderingHint(TextRenderingHintAntiAlias);
+    // Record the whole frame. The Renderer works out what actually changed.
+    void Record(RenderList& list, int width, int height, int fps) {
+        PROFILE_ZONE("UIManager::Record");
+        list.Clear();
 
         // Clear background
-        SolidBrush bgBrush(Color(255, 20, 20, 30));
-        graphics.FillRectangle(&bgBrush, 0, 0, width, height);
-
-        // Set up fonts
-        FontFamily fontFamily(L"Arial");
-        Font titleFont(&fontFamily, 24, FontStyleBold, UnitPixel);
-        Font resourceFont(&fontFamily, 18, FontStyleRegular, UnitPixel);
-        Font smallFont(&fontFamily, 14, FontStyleRegular, UnitPixel);
-        Font buttonFont(&fontFamily, 14, FontStyleBold, UnitPixel);
-        Font tinyFont(&fontFamily, 11, FontStyleRegular, UnitPixel);
-
-        RenderTitle(graphics, titleFont);
-        RenderFPS(graphics, smallFont, fps);
-        RenderResources(graphics, resourceFont, game);
-        RenderProductionRates(graphics, smallFont, game);
-        RenderBuildings(graphics, resourceFont, smallFont, game);
-        RenderButtons(graphics, buttonFont, tinyFont, game);
-        RenderFeedback(graphics, resourceFont);
+        list.FillRect(RenderRect{ 0.0f, 0.0f, (float)width, (float)height }, MakeColor(255, 20, 20, 30));
+
+        RecordTitle(list);
+        RecordFPS(list, fps);
+        RecordResources(list);
+        RecordProductionRates(list);
+        RecordBuildings(list);
+        RecordButtons(list);
+        RecordFeedback(list);
+        if (showProfiler) RecordProfilerOverlay(list);
     }
 
 private:
-    void RenderTitle(Graphics& graphics, Font& font) {
-        SolidBrush goldBrush(Color(255, 255, 215, 0));
-        PointF titlePos(300.0f, 20.0f);
-        graphics.DrawString(L"=== PROCEDURAL CIVILIZATION ===", -1, &font, titlePos, &goldBrush);
-    }
-
-    void RenderFPS(Graphics& graphics, Font& font, int fps) {
-        SolidBrush whiteBrush(Color(255, 255, 255, 255));
-        std::wstringstream fpsStream;
-        fpsStream << L"FPS: " << fps;
-        PointF fpsPos(10.0f, 10.0f);
-        graphics.DrawString(fpsStream.str().c_str(), -1, &font, fpsPos, &whiteBrush);
-    }
-
-    void RenderResources(Graphics& graphics, Font& font, const GameState& game) {
-        SolidBrush foodBrush(Color(255, 100, 255, 100));
-        SolidBrush woodBrush(Color(255, 139, 69, 19));
-        SolidBrush stoneBrush(Color(255, 128, 128, 128));
-        SolidBrush goldBrush(Color(255, 255, 215, 0));
-
-        float yPos = 80.0f;
-        float xPos = 30.0f;
+    static constexpr float kScrollBarWidth = 6.0f;
+
+    int buttonsBegin = 0;               // Building shown by buildingButtons[0]
+    int wheelDelta = 0;                 // Wheel movement not yet scrolled
+
+    // Match the button pool to the visible cells. Labels and enabled state
+    // come from the model, which keeps exactly these buildings up to date.
+    void LayoutBuildingButtons() {
+        int begin = buildingList.VisibleBegin();
+        int end = buildingList.VisibleEnd();
+        bool scrolled = begin != buttonsBegin;
+        buttonsBegin = begin;
+        if ((int)buildingButtons.size() != end - begin) {
+            buildingButtons.resize(end - begin, Button(0.0f, 0.0f, 0.0f, 0.0f, L"", MakeColor(255, 60, 60, 100)));
+        }
 
-        auto renderResource = [&](ResourceType type, SolidBrush& brush) {
-            auto it = game.resources.find(type);
-            if (it != game.resources.end()) {
-                std::wstringstream ss;
-                ss << it->second.name << L": " << std::fixed << std::setprecision(1) << it->second.amount;
-                PointF pos(xPos, yPos);
-                graphics.DrawString(ss.str().c_str(), -1, &font, pos, &brush);
-                yPos += 35.0f;
+        for (int i = begin; i < end; i++) {
+            Button& button = buildingButtons[i - begin];
+            RenderRect rect = buildingList.ItemRect(i);
+            button.x = rect.x;
+            button.y = rect.y;
+            button.width = rect.width;
+            button.height = rect.height;
+            if (scrolled) button.isPressed = false;
+
+            if (i < (int)model.buildings.size()) {
+                const auto& widget = model.buildings[i];
+                button.isEnabled = widget.affordable;
+                if (button.text != widget.label) button.text = widget.label;
             }
-            };
+            else {
+                button.isEnabled = false;
+            }
+        }
+    }
 
-        renderResource(ResourceType::Food, foodBrush);
-        renderResource(ResourceType::Wood, woodBrush);
-        renderResource(ResourceType::Stone, stoneBrush);
-        renderResource(ResourceType::Gold, goldBrush);
+    void RecordTitle(RenderList& list) {
+        static const std::wstring title = L"=== PROCEDURAL CIVILIZATION ===";
+        list.Text(title, RenderRect{ 300.0f, 20.0f, 480.0f, 32.0f }, RenderFont::Title, MakeColor(255, 255, 215, 0));
     }
 
-    void RenderProductionRates(Graphics& graphics, Font& font, const GameState& game) {
-        SolidBrush grayBrush(Color(255, 200, 200, 200));
+    void RecordFPS(RenderList& list, int fps) {
+        model.UpdateFps(fps);
+        list.Text(model.fpsText, RenderRect{ 10.0f, 10.0f, 200.0f, 18.0f }, RenderFont::Small, MakeColor(255, 255, 255, 255));
+        list.Text(model.statsText, RenderRect{ 10.0f, 28.0f, 200.0f, 18.0f }, RenderFont::Small, MakeColor(255, 150, 150, 150));
+        list.Text(model.simulationText, RenderRect{ 10.0f, 46.0f, 260.0f, 18.0f }, RenderFont::Small, MakeColor(255, 150, 150, 150));
+    }
 
-        std::wstringstream prodStream;
-        prodStream << L"Production/sec:";
+    void RecordResources(RenderList& list) {
+        static const RenderColor colors[kResourceCount] = {
+            MakeColor(255, 100, 255, 100),      // Food
+            MakeColor(255, 139, 69, 19),        // Wood
+            MakeColor(255, 128, 128, 128),      // Stone
+            MakeColor(255, 255, 215, 0),        // Gold
+        };
 
-        for (const auto& res : game.resources) {
-            prodStream << L"\n  " << res.second.name << L": +"
-                << std::fixed << std::setprecision(1) << res.second.perSecond;
+        float yPos = 80.0f;
+        float xPos = 30.0f;
+        for (int r = 0; r < kResourceCount; r++) {
+            list.Text(model.resources[r].text, RenderRect{ xPos, yPos, 340.0f, 26.0f }, RenderFont::Resource, colors[r]);
+            yPos += 35.0f;
         }
-
-        RectF prodRect(30.0f, 230.0f, 200.0f, 120.0f);
-        graphics.DrawString(prodStream.str().c_str(), -1, &font, prodRect, NULL, &grayBrush);
     }
 
-    void RenderBuildings(Graphics& graphics, Font& headerFont, Font& smallFont, const GameState& game) {
-        SolidBrush whiteBrush(Color(255, 255, 255, 255));
-        SolidBrush grayBrush(Color(255, 180, 180, 180));
+    void RecordProductionRates(RenderList& list) {
+        list.Text(model.productionText, RenderRect{ 30.0f, 230.0f, 200.0f, 120.0f }, RenderFont::Small, MakeColor(255, 200, 200, 200));
+    }
 
-        PointF buildingHeaderPos(400.0f, 300.0f);
-        graphics.DrawString(L"=== BUILDINGS ===", -1, &headerFont, buildingHeaderPos, &whiteBrush);
+    void RecordBuildings(RenderList& list) {
+        static const std::wstring header = L"=== BUILDINGS ===";
+        list.Text(header, RenderRect{ 400.0f, 300.0f, 300.0f, 26.0f }, RenderFont::Resource, MakeColor(255, 255, 255, 255));
     }
 
-    void RenderButtons(Graphics& graphics, Font& buttonFont, Font& tinyFont, const GameState& game) {
-        // Render gather buttons
-        for (auto& button : gatherButtons) {
-            button.Render(graphics, buttonFont);
+    void RecordButtons(RenderList& list) {
+        // Gather buttons
+        for (const auto& button : gatherButtons) {
+            button.Record(list);
         }
 
-        // Render building buttons with cost info
-        for (size_t i = 0; i < buildingButtons.size(); i++) {
-            buildingButtons[i].Render(graphics, buttonFont);
-
-            // Draw cost below button
-            if (i < game.buildings.size()) {
-                auto cost = game.buildings[i].GetNextCost();
-                std::wstringstream costStream;
-                costStream << L"Cost: ";
-                bool first = true;
-                for (const auto& c : cost) {
-                    if (!first) costStream << L", ";
-                    first = false;
-
-                    std::wstring resName;
-                    switch (c.first) {
-                    case ResourceType::Food: resName = L"F"; break;
-                    case ResourceType::Wood: resName = L"W"; break;
-                    case ResourceType::Stone: resName = L"S"; break;
-                    case ResourceType::Gold: resName = L"G"; break;
-                    }
-                    costStream << resName << L":" << (int)c.second;
-                }
+        // Visible building buttons with cost info below
+        for (size_t k = 0; k < buildingButtons.size(); k++) {
+            const Button& button = buildingButtons[k];
+            button.Record(list);
 
-                SolidBrush costBrush(Color(255, 150, 150, 150));
-                PointF costPos(buildingButtons[i].x + 5, buildingButtons[i].y + buildingButtons[i].height + 2);
-                graphics.DrawString(costStream.str().c_str(), -1, &tinyFont, costPos, &costBrush);
+            size_t i = buttonsBegin + k;
+            if (i < model.buildings.size()) {
+                RenderRect costRect{ button.x + 5, button.y + button.height + 2, button.width + 5, 14.0f };
+                list.Text(model.buildings[i].costLine, costRect, RenderFont::Tiny, MakeColor(255, 150, 150, 150));
             }
         }
+
+        if (buildingList.CanScroll()) {
+            list.FillRect(buildingList.ScrollTrack(kScrollBarWidth), MakeColor(255, 40, 40, 50));
+            list.FillRect(buildingList.ScrollThumb(kScrollBarWidth), MakeColor(255, 120, 120, 140));
+        }
     }
 
-    void RenderFeedback(Graphics& graphics, Font& font) {
-        if (!clickFeedback.empty() && feedbackTimer > 0.0f) {
-            SolidBrush feedbackBrush(Color(255, 255, 255, 100));
-            PointF feedbackPos(400.0f, 250.0f);
-            graphics.DrawString(clickFeedback.c_str(), -1, &font, feedbackPos, &feedbackBrush);
+    // Always recorded (empty when idle) so the frame keeps the same shape
+    // and only this line is redrawn when feedback comes and goes
+    void RecordFeedback(RenderList& list) {
+        static const std::wstring none;
+        const std::wstring& text = feedbackTimer > 0.0f ? clickFeedback : none;
+        list.Text(text, RenderRect{ 400.0f, 250.0f, 380.0f, 26.0f }, RenderFont::Resource, MakeColor(255, 255, 255, 100));
+    }
+
+    // Frame-time percentiles and a histogram with one bar per millisecond
+    void RecordProfilerOverlay(RenderList& list) {
+        const int kBars = 64;
+        const int kBucketsPerBar = FrameTimeStats::kBucketCount / kBars;
+        const float kBarWidth = 5.0f;
+        const float kGraphHeight = 80.0f;
+        RenderRect panel{ 30.0f, 400.0f, kBars * kBarWidth + 10.0f, kGraphHeight + 32.0f };
+
+        model.UpdateFrameTimes(frameTimes.PercentileMillis(0.5), frameTimes.PercentileMillis(0.99));
+        list.FillRect(panel, MakeColor(200, 0, 0, 0));
+        list.Text(model.frameTimeText, RenderRect{ panel.x + 5.0f, panel.y + 4.0f, panel.width - 10.0f, 18.0f },
+            RenderFont::Small, MakeColor(255, 200, 200, 200));
+
+        int bars[kBars] = {};
+        int tallest = 1;
+        for (int b = 0; b < FrameTimeStats::kBucketCount; b++) bars[b / kBucketsPerBar] += frameTimes.Bucket(b);
+        for (int bar : bars) tallest = std::max(tallest, bar);
+
+        // Whole-pixel heights, so the bars only redraw when they visibly move
+        float baseline = panel.Bottom() - 5.0f;
+        for (int i = 0; i < kBars; i++) {
+            float height = std::floor(kGraphHeight * bars[i] / tallest);
+            RenderColor color = i < 17 ? MakeColor(255, 80, 200, 80) : i < 34 ? MakeColor(255, 220, 200, 60) : MakeColor(255, 220, 70, 70);
+            list.FillRect(RenderRect{ panel.x + 5.0f + i * kBarWidth, baseline - height, kBarWidth - 1.0f, height }, color);
         }
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,239 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "game.h"
+#include "numberformat.h"
+#include "scheduler.h"
+
+// Display text and state derived from a GameState, kept between frames.
+//
+// Each widget remembers the GameState change counters it was built from
+// and is only rebuilt when one of them moves, so a frame where nothing
+// visible changed does no formatting and no allocation. Enabled state comes
+// from an AffordabilityScheduler, which also provides the "ready in" time.
+// Text is rebuilt in place with numberformat.h, so once the strings have
+// grown to size, rebuilding does not allocate either. Building widgets are
+// only maintained inside the visible range, so a scrolled list of any
+// length costs the same per frame.
+// Portable (no GDI+), so it can be driven and measured headless.
+class UIModel {
+public:
+    struct ResourceWidget {
+        std::wstring text;                  // "Food: 123.4", "Food: 4.5M"
+        uint64_t amountVersion = ~0ull;
+        int64_t shownTenths = 0;            // Displayed value, when it fits in 64 bits
+        bool shownExact = false;
+    };
+
+    struct BuildingWidget {
+        std::wstring label;                 // "Farm (3)"
+        std::wstring costText;              // "Cost: W:10"
+        std::wstring costLine;              // Cost text plus " (12s)" until affordable
+        bool affordable = false;
+        int64_t shownWait = -1;             // Whole seconds shown in costLine, -1 for none
+        uint64_t version = ~0ull;
+    };
+
+    ResourceWidget resources[kResourceCount];
+    std::vector<BuildingWidget> buildings;
+    std::wstring productionText;
+    std::wstring fpsText;
+    std::wstring statsText;
+    std::wstring simulationText;        // Empty unless the game runs on a simulation thread
+    std::wstring frameTimeText;         // Profiler overlay
+
+    AffordabilityScheduler scheduler;
+
+    NumberNotation Notation() const { return notation; }
+
+    // Amounts, rates and costs; everything is rebuilt on the next Update()
+    void SetNotation(NumberNotation value) {
+        if (value == notation) return;
+        notation = value;
+        contentVersion = ~0ull;
+    }
+
+    // Widgets rebuilt in the last complete frame (shown by the UI)
+    int RecomputedLastFrame() const { return recomputedLastFrame; }
+
+    void BeginFrame() {
+        recomputedLastFrame = recomputedThisFrame;
+        recomputedThisFrame = 0;
+    }
+
+    // Building widgets outside [begin, end) are left as they are until they
+    // come back into range; everything they show is then brought up to date
+    void SetVisibleBuildings(int begin, int end) {
+        visibleBegin = begin;
+        visibleEnd = end;
+    }
+
+    // `now` is any clock in seconds that advances with the game
+    void Update(const GameState& game, double now) {
+        if (game.contentVersion != contentVersion) {
+            // New content or a loaded save: start over
+            contentVersion = game.contentVersion;
+            buildings.assign(game.buildings.size(), BuildingWidget());
+            for (auto& resource : resources) resource = ResourceWidget();
+            ratesVersion = ~0ull;
+        }
+
+        for (int r = 0; r < kResourceCount; r++) UpdateResource(game, r);
+
+        if (game.ratesVersion != ratesVersion) {
+            ratesVersion = game.ratesVersion;
+            productionText.assign(L"Production/sec:");
+            for (int r = 0; r < kResourceCount; r++) {
+                productionText += L"\n  ";
+                productionText += game.resourceNames[r];
+                productionText += L": +";
+                AppendNumber(productionText, FormatNumber(game.rates[r], 1, notation));
+            }
+            recomputedThisFrame++;
+        }
+
+        int begin = std::max(0, visibleBegin);
+        int end = std::min((int)buildings.size(), visibleEnd);
+        for (int i = begin; i < end; i++) UpdateBuilding(game, i);
+
+        // Affordability only changes on scheduler events
+        flipped.clear();
+        scheduler.Update(game, now, &flipped);
+        for (int i : flipped) {
+            buildings[i].affordable = scheduler.IsAffordable(i);
+            recomputedThisFrame++;
+        }
+
+        for (int i = begin; i < end; i++) UpdateCostLine(i, now);
+    }
+
+    void UpdateFps(int fps) {
+        if (fps != shownFps) {
+            shownFps = fps;
+            fpsText.assign(L"FPS: ");
+            AppendNumber(fpsText, FormatInteger(fps));
+            recomputedThisFrame++;
+        }
+        if (recomputedLastFrame != shownRecomputed) {
+            shownRecomputed = recomputedLastFrame;
+            statsText.assign(L"Widgets updated: ");
+            AppendNumber(statsText, FormatInteger(recomputedLastFrame));
+            recomputedThisFrame++;
+        }
+    }
+
+    // Tick rate and how late the simulation thread wakes, shown to a tenth
+    void UpdateSimulation(double hz, double lateMillis) {
+        int64_t shownHz = std::llround(hz * 10.0);
+        int64_t shownLate = std::llround(lateMillis * 10.0);
+        if (shownHz == shownSimulationHz && shownLate == shownSimulationLate) return;
+        shownSimulationHz = shownHz;
+        shownSimulationLate = shownLate;
+
+        simulationText.assign(L"Sim: ");
+        AppendNumber(simulationText, FormatNumber(shownHz / 10.0, 1));
+        simulationText += L" Hz, late ";
+        AppendNumber(simulationText, FormatNumber(shownLate / 10.0, 1));
+        simulationText += L" ms";
+        recomputedThisFrame++;
+    }
+
+    void UpdateFrameTimes(double p50Millis, double p99Millis) {
+        if (p50Millis == shownP50 && p99Millis == shownP99) return;
+        shownP50 = p50Millis;
+        shownP99 = p99Millis;
+
+        frameTimeText.assign(L"Frame time p50 ");
+        AppendNumber(frameTimeText, FormatNumber(p50Millis, 2));
+        frameTimeText += L" ms, p99 ";
+        AppendNumber(frameTimeText, FormatNumber(p99Millis, 2));
+        frameTimeText += L" ms";
+        recomputedThisFrame++;
+    }
+
+private:
+    NumberNotation notation = NumberNotation::Compact;
+    uint64_t contentVersion = ~0ull;
+    uint64_t ratesVersion = ~0ull;
+    int visibleBegin = 0;
+    int visibleEnd = std::numeric_limits<int>::max();
+    int shownFps = -1;
+    int shownRecomputed = -1;
+    int64_t shownSimulationHz = -1;
+    int64_t shownSimulationLate = -1;
+    double shownP50 = -1.0;
+    double shownP99 = -1.0;
+    int recomputedThisFrame = 0;
+    int recomputedLastFrame = 0;
+    std::vector<int> flipped;
+
+    void UpdateResource(const GameState& game, int r) {
+        ResourceWidget& widget = resources[r];
+        if (game.amountVersions[r] == widget.amountVersion) return;
+        widget.amountVersion = game.amountVersions[r];
+
+        // Amounts move every frame but the text shows one decimal; only
+        // reformat when the displayed digits change
+        const BigNumber& amount = game.amounts[r];
+        bool exact = amount.exponent == 0 && std::fabs(amount.mantissa) < 1e15;
+        int64_t tenths = exact ? std::llround(amount.mantissa * 10.0) : 0;
+        if (exact && widget.shownExact && tenths == widget.shownTenths && !widget.text.empty()) return;
+        widget.shownExact = exact;
+        widget.shownTenths = tenths;
+
+        widget.text.assign(game.resourceNames[r]);
+        widget.text += L": ";
+        AppendNumber(widget.text, FormatNumber(amount, 1, notation));
+        recomputedThisFrame++;
+    }
+
+    void UpdateBuilding(const GameState& game, int i) {
+        BuildingWidget& widget = buildings[i];
+        const Building& building = game.buildings[i];
+
+        if (building.version != widget.version) {
+            widget.version = building.version;
+            const ResourceAmounts& nextCost = building.GetNextCost();
+
+            widget.label.assign(building.type->name);
+            widget.label += L" (";
+            AppendNumber(widget.label, FormatInteger(building.count));
+            widget.label += L")";
+
+            widget.costText.assign(L"Cost: ");
+            bool first = true;
+            for (int r = 0; r < kResourceCount; r++) {
+                if (nextCost[r] <= 0.0) continue;
+                if (!first) widget.costText += L", ";
+                first = false;
+                widget.costText.append(game.resourceNames[r], 0, 1);
+                widget.costText += L":";
+                AppendNumber(widget.costText, FormatNumber(nextCost[r], 0, notation));
+            }
+            widget.shownWait = -2;
+            recomputedThisFrame++;
+        }
+    }
+
+    // The countdown text changes once a second at most
+    void UpdateCostLine(int i, double now) {
+        BuildingWidget& widget = buildings[i];
+        double wait = scheduler.TimeUntilAffordable(i, now);
+        int64_t shownWait = -1;
+        if (!widget.affordable && wait < AffordabilityScheduler::kNever && wait < 1e9) shownWait = (int64_t)std::ceil(wait);
+        if (shownWait == widget.shownWait) return;
+
+        widget.shownWait = shownWait;
+        widget.costLine.assign(widget.costText);
+        if (shownWait >= 0) {
+            widget.costLine += L" (";
+            AppendNumber(widget.costLine, FormatInteger(shownWait));
+            widget.costLine += L"s)";
+        }
+        recomputedThisFrame++;
+    }
+};